@@ -0,0 +1,18 @@
+#!/bin/bash
+### Build & run every bench/*.cpp, or only those named ($@ : session_table ...)
+if [ ! -d ./build/bench ]; then
+    mkdir -p ./build/bench
+fi
+
+names=("$@")
+if [ ${#names[@]} -eq 0 ]; then
+    for source in bench/*.cpp; do
+        names+=("$(basename "$source" .cpp)")
+    done
+fi
+
+for name in "${names[@]}"; do
+    g++ -O2 -std=c++20 "bench/$name.cpp" -o "./build/bench/$name.out" -lfmt -lssl -lcrypto -lmysqlcppconn8 -lboost_system -lcpprest -lz -pthread || exit 1
+    echo "== $name"
+    "./build/bench/$name.out" || exit 1
+done
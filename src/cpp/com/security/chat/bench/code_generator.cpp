@@ -0,0 +1,71 @@
+/**
+ * Cost of session keys, salts & invitation codes
+ * module::secure (thread-local OpenSSL DRBG buffer) against the generator
+ * it replaced, which seeded a std::default_random_engine from
+ * std::random_device on every call
+ */
+#include "../module/secure.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <string>
+
+using namespace chat;
+
+static std::string legacyCode(uint64_t length) {
+  static constexpr char charset[] =
+      "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+  std::default_random_engine rng(std::random_device{}());
+  std::uniform_int_distribution<> dist(0, sizeof(charset) - 2);
+  std::string str(length, 0);
+  std::generate_n(str.begin(), length, [&]() { return charset[dist(rng)]; });
+  return str;
+}
+
+static uint64_t legacyNumber() {
+  std::random_device rd;
+  std::mt19937_64 gen(rd());
+  return std::uniform_int_distribution<uint64_t>()(gen);
+}
+
+static double nsPerCall(uint64_t calls, const std::function<uint64_t()> &f) {
+  uint64_t sink = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (uint64_t i = 0; i < calls; ++i) {
+    sink += f();
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  if (sink == 1) {
+    printf(" ");
+  }
+  return std::chrono::duration<double, std::nano>(elapsed).count() / calls;
+}
+
+int main() {
+  printf("%-24s %14s %14s %10s\n", "", "ns/call", "ns/char", "speedup");
+  for (uint64_t length : {8, 100, 512}) {
+    constexpr uint64_t calls = 20000;
+    auto current = nsPerCall(calls, [length]() {
+      return uint64_t(module::secure::generateFixedLengthCode(length)[0]);
+    });
+    auto legacy = nsPerCall(
+        calls, [length]() { return uint64_t(legacyCode(length)[0]); });
+    printf("code(%3llu) drbg buffer    %14.1f %14.2f %9.1fx\n",
+           (unsigned long long)length, current, current / length,
+           legacy / current);
+    printf("code(%3llu) random_device  %14.1f %14.2f\n",
+           (unsigned long long)length, legacy, legacy / length);
+  }
+
+  constexpr uint64_t calls = 200000;
+  auto current = nsPerCall(calls, module::secure::generateRandomNumber);
+  auto legacy = nsPerCall(calls, legacyNumber);
+  printf("number     drbg buffer    %14.1f %14s %9.1fx\n", current, "-",
+         legacy / current);
+  printf("number     random_device  %14.1f %14s\n", legacy, "-");
+  return 0;
+}
@@ -0,0 +1,90 @@
+/**
+ * Memory per cached session & lookups per second at 1M live sessions
+ * The sessions share one principal, so the figure is the session record
+ * plus its share of the table (stripe maps, principal index), without the
+ * User / Company entities themselves
+ */
+#include "../dao/server_session/memory_repository.hpp"
+
+#include <spdlog/logger.h>
+#include <spdlog/sinks/null_sink.h>
+
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace chat;
+
+static uint64_t residentBytes() {
+  // resident pages of this process, from /proc/self/statm
+  uint64_t size = 0;
+  uint64_t resident = 0;
+  std::ifstream("/proc/self/statm") >> size >> resident;
+  return resident * sysconf(_SC_PAGESIZE);
+}
+
+int main() {
+  constexpr uint64_t live = 1000000;
+  constexpr auto duration = std::chrono::seconds(2);
+
+  auto logger = std::make_shared<spdlog::logger>(
+      "BENCH", std::make_shared<spdlog::sinks::null_sink_st>());
+  auto repository = dao::ServerSessionRepository::getInstance(logger);
+  auto principal = std::make_shared<dao::Company>("bench", 1);
+  auto expiredAt = module::getCurrentTime() + 3600;
+  auto session = mysqlx::Session{};
+
+  auto ids = std::vector<uint64_t>{};
+  ids.reserve(live);
+  auto before = residentBytes();
+  for (uint64_t i = 0; i < live; ++i) {
+    auto saved = repository->save(
+        session, std::make_shared<dao::ServerSession>(principal, expiredAt));
+    ids.push_back(saved->getId());
+  }
+  auto after = residentBytes();
+  auto idBytes = ids.capacity() * sizeof(uint64_t);
+
+  printf("sizeof(ServerSession) : %zu bytes\n", sizeof(dao::ServerSession));
+  printf("resident per session  : %.1f bytes (%llu sessions)\n",
+         double(after - before - idBytes) / live,
+         (unsigned long long)repository->size());
+
+  printf("%8s %16s\n", "threads", "lookups/s");
+  for (unsigned threads = 1; threads <= 8; threads *= 2) {
+    auto stop = std::atomic<bool>{false};
+    auto total = std::atomic<uint64_t>{0};
+    auto workers = std::vector<std::thread>{};
+    for (unsigned t = 0; t < threads; ++t) {
+      workers.emplace_back([&, t]() {
+        auto random = std::mt19937_64(t);
+        uint64_t lookups = 0;
+        uint64_t missed = 0;
+        while (stop.load(std::memory_order_relaxed) == false) {
+          missed += repository->find(ids[random() % live]) == nullptr;
+          ++lookups;
+        }
+        total.fetch_add(lookups, std::memory_order_relaxed);
+        if (missed != 0) {
+          printf("%llu sessions missing\n", (unsigned long long)missed);
+        }
+      });
+    }
+    std::this_thread::sleep_for(duration);
+    stop = true;
+    for (auto &worker : workers) {
+      worker.join();
+    }
+    printf("%8u %16.0f\n", threads,
+           total.load() / std::chrono::duration<double>(duration).count());
+  }
+  return 0;
+}
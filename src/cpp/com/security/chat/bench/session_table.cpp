@@ -0,0 +1,82 @@
+/**
+ * Throughput of dao::ServerSessionRepository under concurrent requests
+ * 100k live sessions. Every thread looks sessions up by random id, the way
+ * each authenticated request does; one operation in 100 is a login (save)
+ * followed by a logout (revoke) of that session, so writers take their
+ * stripe exclusively meanwhile
+ */
+#include "../dao/server_session/memory_repository.hpp"
+
+#include <spdlog/logger.h>
+#include <spdlog/sinks/null_sink.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace chat;
+
+int main() {
+  constexpr uint64_t live = 100000;
+  constexpr auto duration = std::chrono::seconds(2);
+
+  auto logger = std::make_shared<spdlog::logger>(
+      "BENCH", std::make_shared<spdlog::sinks::null_sink_st>());
+  auto repository = dao::ServerSessionRepository::getInstance(logger);
+  auto principal = std::make_shared<dao::Company>("bench", 1);
+  auto expiredAt = module::getCurrentTime() + 3600;
+  auto session = mysqlx::Session{};
+
+  auto ids = std::vector<uint64_t>{};
+  ids.reserve(live);
+  for (uint64_t i = 0; i < live; ++i) {
+    auto saved = repository->save(
+        session, std::make_shared<dao::ServerSession>(principal, expiredAt));
+    ids.push_back(saved->getId());
+  }
+
+  printf("%llu sessions, %u hardware threads\n", (unsigned long long)live,
+         std::thread::hardware_concurrency());
+  printf("%8s %16s %16s\n", "threads", "ops/s", "ops/s/thread");
+  for (unsigned threads = 1; threads <= 8; threads *= 2) {
+    auto stop = std::atomic<bool>{false};
+    auto total = std::atomic<uint64_t>{0};
+    auto workers = std::vector<std::thread>{};
+    for (unsigned t = 0; t < threads; ++t) {
+      workers.emplace_back([&, t]() {
+        auto random = std::mt19937_64(t);
+        uint64_t ops = 0;
+        uint64_t found = 0;
+        while (stop.load(std::memory_order_relaxed) == false) {
+          if (ops % 100 == 99) {
+            auto saved = repository->save(
+                session,
+                std::make_shared<dao::ServerSession>(principal, expiredAt));
+            repository->revoke(saved->getId(), expiredAt);
+          } else {
+            found += repository->find(ids[random() % live]) != nullptr;
+          }
+          ++ops;
+        }
+        total.fetch_add(ops, std::memory_order_relaxed);
+        if (found == 0) {
+          printf("no session found\n");
+        }
+      });
+    }
+    std::this_thread::sleep_for(duration);
+    stop = true;
+    for (auto &worker : workers) {
+      worker.join();
+    }
+    auto perSecond =
+        total.load() / std::chrono::duration<double>(duration).count();
+    printf("%8u %16.0f %16.0f\n", threads, perSecond, perSecond / threads);
+  }
+  return 0;
+}
@@ -0,0 +1,82 @@
+/**
+ * module::validator against the std::regex / <cctype> checks it replaced
+ * The regex is timed both as it was used (built on every call) and
+ * precompiled once, the best std::regex can do
+ */
+#include "../module/validator.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <regex>
+#include <string>
+#include <vector>
+
+using namespace chat;
+
+static const char *pattern = "(\\w+)(\\.|_)?(\\w*)@(\\w+)(\\.(\\w+))+";
+
+static double nsPerCall(const std::vector<std::string> &inputs,
+                        uint64_t rounds,
+                        const std::function<bool(const std::string &)> &f) {
+  uint64_t accepted = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (uint64_t round = 0; round < rounds; ++round) {
+    for (const auto &input : inputs) {
+      accepted += f(input);
+    }
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  if (accepted == uint64_t(-1)) {
+    printf(" ");
+  }
+  return std::chrono::duration<double, std::nano>(elapsed).count() /
+         (rounds * inputs.size());
+}
+
+int main() {
+  auto emails = std::vector<std::string>{
+      "user@naver.com",         "first.last@mail.co.kr", "a_b@c.d",
+      "no-at-sign.example.com", "trailing@dot.",         "x@y",
+      "long.name_with.parts@sub.domain.example.org"};
+  auto names = std::vector<std::string>{"Room42", "hello world", "abc",
+                                        "AVeryLongRoomNameWithDigits0123456789",
+                                        "semi;colon"};
+
+  auto precompiled = std::regex(pattern);
+  auto dfa = nsPerCall(emails, 200000, [](const std::string &email) {
+    return module::validator::isEmail(email);
+  });
+  auto compiled = nsPerCall(emails, 20000, [&](const std::string &email) {
+    return std::regex_match(email, precompiled);
+  });
+  auto perCall = nsPerCall(emails, 200, [](const std::string &email) {
+    return std::regex_match(email, std::regex(pattern));
+  });
+
+  printf("%-28s %12s %10s\n", "e-mail", "ns/call", "vs dfa");
+  printf("%-28s %12.1f %10s\n", "validator dfa", dfa, "1.0x");
+  printf("%-28s %12.1f %9.1fx\n", "std::regex precompiled", compiled,
+         compiled / dfa);
+  printf("%-28s %12.1f %9.1fx\n", "std::regex built per call", perCall,
+         perCall / dfa);
+
+  auto table = nsPerCall(names, 500000, [](const std::string &name) {
+    return module::validator::isAlnum(name);
+  });
+  auto cctype = nsPerCall(names, 500000, [](const std::string &name) {
+    return size_t(std::count_if(name.begin(), name.end(),
+                                [](unsigned char c) {
+                                  return std::isalpha(c) || std::isdigit(c);
+                                })) == name.size();
+  });
+
+  printf("\n%-28s %12s %10s\n", "user input", "ns/call", "vs table");
+  printf("%-28s %12.1f %10s\n", "validator table", table, "1.0x");
+  printf("%-28s %12.1f %9.1fx\n", "count_if isalpha/isdigit", cctype,
+         cctype / table);
+  return 0;
+}
@@ -1,8 +1,11 @@
 #pragma once
 
 #include "auth.hpp"
+#include "batch.hpp"
 #include "company.hpp"
 #include "invitation.hpp"
+#include "metrics.hpp"
 #include "participant.hpp"
 #include "room.hpp"
+#include "router.hpp"
 #include "user.hpp"
\ No newline at end of file
@@ -26,9 +26,9 @@ using namespace chat::module::exception;
 #include <atomic>
 #include <exception>
 #include <functional>
+#include <list>
 #include <memory>
 #include <string>
-#include <thread>
 
 namespace chat::controller {
 class AuthController : public BaseController {
@@ -43,20 +43,9 @@ public:
     return instance;
   }
   AuthController(web::uri baseUri, L serverLogger, CN conn, CONFIG &config)
-      : BaseController(baseUri, serverLogger, conn, config) {
-    web::uri_builder baseBuilder{baseUri};
+      : BaseController(baseUri, serverLogger, conn, config) {}
 
-    this->loginUri = baseBuilder.set_path("/auth/login").to_uri();
-    this->loginListener = web::http::experimental::listener::http_listener{
-        this->loginUri, config};
-
-    auto logoutConfig = CONFIG{config};
-    this->logoutUri = baseBuilder.set_path("/auth/logout").to_uri();
-    this->logoutListener = web::http::experimental::listener::http_listener{
-        this->logoutUri, config};
-  }
-
-  static void handleLogin(web::http::http_request request) {
+  static pplx::task<void> handleLogin(web::http::http_request request) {
     /**
      * header : application/json
      * query : type=[company|user]
@@ -73,7 +62,7 @@ public:
 
     try {
       // main routine
-      auto body = request.extract_json().get();
+      auto body = co_await request.extract_json();
       auto splitedQueries = web::uri::split_query(query);
       auto typeIter = splitedQueries.find("type");
       if (typeIter == splitedQueries.end()) {
@@ -87,16 +76,19 @@ public:
         auto name = bodyAt(body, "name");
         auto password = bodyAt(body, "password");
 
-        session = std::dynamic_pointer_cast<service::AuthService>(
+        // resumed once the password has been hashed
+        session = co_await std::dynamic_pointer_cast<service::AuthService>(
                       instance->authService)
-                      ->loginOfCompany(name, password);
+                      ->loginOfCompany(name, password,
+                                       request.remote_address());
 
       } else if (type == "user") {
         auto email = bodyAt(body, "email");
         auto password = bodyAt(body, "password");
-        session = std::dynamic_pointer_cast<service::AuthService>(
+        session = co_await std::dynamic_pointer_cast<service::AuthService>(
                       instance->authService)
-                      ->loginOfUser(email, password);
+                      ->loginOfUser(email, password,
+                                    request.remote_address());
       } else {
         throw ControllerException(fmt::v9::format("not specified type"));
       }
@@ -150,6 +142,18 @@ public:
           web::http::status_codes::OK,
           dto::Response(dto::CODE::NOT_SAVED, sendMsg, data).serialize());
 
+    } catch (const OverloadedException &e) {
+      auto msg =
+          fmt::v9::format("AuthController[LOGIN]({})", requestUri.to_string());
+      auto logMsg = fmt::v9::format("{} : {}", msg, e.what());
+      auto sendMsg = fmt::v9::format("{} : TOO_MANY_REQUESTS", msg);
+
+      instance->serverLogger->error(logMsg);
+      auto data = dto::ExceptionData(dto::CODE::TOO_MANY_REQUESTS, sendMsg);
+      request.reply(web::http::status_codes::OK,
+                    dto::Response(dto::CODE::TOO_MANY_REQUESTS, sendMsg, data)
+                        .serialize());
+
     } catch (const std::exception &e) {
       auto msg =
           fmt::v9::format("AuthController[LOGIN]({})", requestUri.to_string());
@@ -164,7 +168,7 @@ public:
     }
   }
 
-  static void handleLogout(web::http::http_request request) {
+  static pplx::task<void> handleLogout(web::http::http_request request) {
     /**
      * header : application/json
      *  - session-id : [id]
@@ -181,10 +185,12 @@ public:
     auto requestUri = request.absolute_uri();
 
     try {
-      auto body = request.extract_json().get();
-
       // 권한 검증
-      auto sessionEntity = instance->authenticateAccess(body);
+      auto sessionEntity = instance->authenticateAccess(headers);
+      auto body = co_await request.extract_json();
+      if (sessionEntity == nullptr) {
+        sessionEntity = instance->authenticateAccess(body);
+      }
 
       auto type = bodyAt(body, "type");
       uint64_t entityId = std::stoull(bodyAt(body, "id"));
@@ -207,7 +213,9 @@ public:
       }
 
       // main routine
-      uint64_t sessionId = std::stoull(bodyAt(body, "session-id"));
+      uint64_t sessionId = std::stoull(hasSession(headers)
+                                           ? headers["session-id"]
+                                           : bodyAt(body, "session-id"));
       if (std::dynamic_pointer_cast<service::AuthService>(instance->authService)
               ->logout(sessionId)) {
         auto msg = fmt::v9::format("AuthController[LOGOUT]({})",
@@ -262,47 +270,227 @@ public:
     }
   }
 
-  void listen() override {
-    std::function<void(web::http::http_request)> loginHandler =
-        &AuthController::handleLogin;
-    std::function<void(web::http::http_request)> logoutHandler =
-        &AuthController::handleLogout;
+  static pplx::task<void> handleRefresh(web::http::http_request request) {
+    /**
+     * header : application/json
+     *  - session-id : [id]
+     *  - session-token : [token]
+     *
+     * or body :
+     *  - session-id : [id]
+     *  - session-token : [token]
+     *
+     * response : session (same id, new token & expiry)
+     */
+
+    auto headers = request.headers();
+    auto requestUri = request.absolute_uri();
+
+    try {
+      auto rawSessionId = std::string{};
+      auto sessionToken = std::string{};
+      if (hasSession(headers)) {
+        rawSessionId = headers["session-id"];
+        sessionToken = headers["session-token"];
+      } else {
+        auto body = co_await request.extract_json();
+        if ((body.has_field("session-id") == false) ||
+            (body.has_field("session-token") == false)) {
+          throw NotAuthorizedException(fmt::v9::format("not authorized"));
+        }
+        rawSessionId = bodyAt(body, "session-id");
+        sessionToken = bodyAt(body, "session-token");
+      }
+      if (module::isNumber(rawSessionId) == false) {
+        throw NotAuthorizedException(fmt::v9::format("not authorized"));
+      }
+
+      // main routine
+      auto session =
+          std::dynamic_pointer_cast<service::AuthService>(instance->authService)
+              ->refresh(std::stoull(rawSessionId), sessionToken);
+
+      auto msg = fmt::v9::format("AuthController[REFRESH]({})",
+                                 requestUri.to_string());
+      auto logMsg = fmt::v9::format("{} : {}", msg, "ok");
+      auto sendMsg = logMsg;
+
+      instance->serverLogger->info(logMsg);
+      auto sessionData = dto::ServerSessionData(
+          *std::dynamic_pointer_cast<dao::ServerSession>(session));
+      request.reply(
+          web::http::status_codes::OK,
+          dto::Response(dto::CODE::OK, sendMsg, sessionData).serialize());
+    } catch (const NotAuthorizedException &e) {
+      auto msg = fmt::v9::format("AuthController[REFRESH]({})",
+                                 requestUri.to_string());
+      auto logMsg = fmt::v9::format("{} : {}", msg, e.what());
+      auto sendMsg = fmt::v9::format("{} : NOT_AUTHRIZED", msg);
+
+      instance->serverLogger->error(logMsg);
+      auto data = dto::ExceptionData(dto::CODE::UNAUTHORIZED, sendMsg);
+      request.reply(
+          web::http::status_codes::OK,
+          dto::Response(dto::CODE::UNAUTHORIZED, sendMsg, data).serialize());
+    } catch (const std::exception &e) {
+      auto msg = fmt::v9::format("AuthController[REFRESH]({})",
+                                 requestUri.to_string());
+      auto logMsg = fmt::v9::format("{} : {}", msg, e.what());
+      auto sendMsg = fmt::v9::format("{} : UNEXPECTED_ERROR", msg);
+
+      instance->serverLogger->error(logMsg);
+      auto data = dto::ExceptionData(dto::CODE::UNEXPECTED, sendMsg);
+      request.reply(
+          web::http::status_codes::OK,
+          dto::Response(dto::CODE::UNEXPECTED, sendMsg, data).serialize());
+    }
+  }
+
+  static pplx::task<void> handleSessions(web::http::http_request request) {
+    /**
+     * header : application/json
+     *  - session-id : [id]
+     *  - session-token : [token]
+     *
+     * response : sessions of the caller's principal (no tokens)
+     */
+
+    auto headers = request.headers();
+    auto requestUri = request.absolute_uri();
+
+    try {
+      // 권한 검증
+      auto sessionEntity = instance->authenticateAccess(headers);
+      if (sessionEntity == nullptr) {
+        sessionEntity =
+            instance->authenticateAccess(co_await request.extract_json());
+      }
+
+      // main routine
+      auto sessions =
+          std::dynamic_pointer_cast<service::AuthService>(instance->authService)
+              ->findAllSessionsOf(sessionEntity);
+      auto sessionDataList = std::list<dto::Data>{};
+      for (auto &session : sessions) {
+        sessionDataList.emplace_back(dto::ServerSessionData(*session, false));
+      }
+
+      auto msg = fmt::v9::format("AuthController[SESSIONS]({})",
+                                 requestUri.to_string());
+      auto logMsg = fmt::v9::format("{} : {}", msg, "ok");
+      auto sendMsg = logMsg;
+
+      instance->serverLogger->info(logMsg);
+      request.reply(web::http::status_codes::OK,
+                    dto::Response(dto::CODE::OK, sendMsg,
+                                  dto::ArrayData(sessionDataList))
+                        .serialize());
+    } catch (const NotAuthorizedException &e) {
+      auto msg = fmt::v9::format("AuthController[SESSIONS]({})",
+                                 requestUri.to_string());
+      auto logMsg = fmt::v9::format("{} : {}", msg, e.what());
+      auto sendMsg = fmt::v9::format("{} : NOT_AUTHRIZED", msg);
+
+      instance->serverLogger->error(logMsg);
+      auto data = dto::ExceptionData(dto::CODE::UNAUTHORIZED, sendMsg);
+      request.reply(
+          web::http::status_codes::OK,
+          dto::Response(dto::CODE::UNAUTHORIZED, sendMsg, data).serialize());
+    } catch (const std::exception &e) {
+      auto msg = fmt::v9::format("AuthController[SESSIONS]({})",
+                                 requestUri.to_string());
+      auto logMsg = fmt::v9::format("{} : {}", msg, e.what());
+      auto sendMsg = fmt::v9::format("{} : UNEXPECTED_ERROR", msg);
+
+      instance->serverLogger->error(logMsg);
+      auto data = dto::ExceptionData(dto::CODE::UNEXPECTED, sendMsg);
+      request.reply(
+          web::http::status_codes::OK,
+          dto::Response(dto::CODE::UNEXPECTED, sendMsg, data).serialize());
+    }
+  }
+
+  static pplx::task<void>
+  handleLogoutEverywhere(web::http::http_request request) {
+    /**
+     * header : application/json
+     *  - session-id : [id]
+     *  - session-token : [token]
+     *
+     * response : msg, every session of the caller's principal is revoked
+     */
 
-    loginListener.support(web::http::methods::POST, loginHandler);
-    logoutListener.support(web::http::methods::DEL, logoutHandler);
+    auto headers = request.headers();
+    auto requestUri = request.absolute_uri();
 
     try {
-      loginListener.open()
-          .then([this]() {
-            serverLogger->info(fmt::v9::format("AuthController : Listening {} ",
-                                               loginUri.to_string()));
-          })
-          .wait();
-
-      logoutListener.open()
-          .then([this]() {
-            serverLogger->info(fmt::v9::format("AuthController : Listening {}",
-                                               logoutUri.to_string()));
-          })
-          .wait();
-      while (true) {
-        std::this_thread::yield();
+      // 권한 검증
+      auto sessionEntity = instance->authenticateAccess(headers);
+      if (sessionEntity == nullptr) {
+        sessionEntity =
+            instance->authenticateAccess(co_await request.extract_json());
       }
+
+      // main routine
+      auto revoked =
+          std::dynamic_pointer_cast<service::AuthService>(instance->authService)
+              ->logoutEverywhere(sessionEntity);
+
+      auto msg = fmt::v9::format("AuthController[LOGOUT_ALL]({})",
+                                 requestUri.to_string());
+      auto logMsg = fmt::v9::format("{} : {} sessions", msg, revoked);
+      auto sendMsg = logMsg;
+
+      instance->serverLogger->info(logMsg);
+      request.reply(
+          web::http::status_codes::OK,
+          dto::Response(dto::CODE::OK, sendMsg, dto::MsgData(sendMsg))
+              .serialize());
+    } catch (const NotAuthorizedException &e) {
+      auto msg = fmt::v9::format("AuthController[LOGOUT_ALL]({})",
+                                 requestUri.to_string());
+      auto logMsg = fmt::v9::format("{} : {}", msg, e.what());
+      auto sendMsg = fmt::v9::format("{} : NOT_AUTHRIZED", msg);
+
+      instance->serverLogger->error(logMsg);
+      auto data = dto::ExceptionData(dto::CODE::UNAUTHORIZED, sendMsg);
+      request.reply(
+          web::http::status_codes::OK,
+          dto::Response(dto::CODE::UNAUTHORIZED, sendMsg, data).serialize());
     } catch (const std::exception &e) {
-      auto msg = fmt::v9::format("AuthController : {}", e.what());
-      serverLogger->error(msg);
-      throw ControllerException(msg);
+      auto msg = fmt::v9::format("AuthController[LOGOUT_ALL]({})",
+                                 requestUri.to_string());
+      auto logMsg = fmt::v9::format("{} : {}", msg, e.what());
+      auto sendMsg = fmt::v9::format("{} : UNEXPECTED_ERROR", msg);
+
+      instance->serverLogger->error(logMsg);
+      auto data = dto::ExceptionData(dto::CODE::UNEXPECTED, sendMsg);
+      request.reply(
+          web::http::status_codes::OK,
+          dto::Response(dto::CODE::UNEXPECTED, sendMsg, data).serialize());
     }
   }
 
+  void route(RT router) override {
+    router->support("/auth/login", web::http::methods::POST,
+                    &AuthController::handleLogin);
+    router->support("/auth/logout", web::http::methods::DEL,
+                    &AuthController::handleLogout);
+    router->support("/auth/refresh", web::http::methods::POST,
+                    &AuthController::handleRefresh);
+    router->support("/auth/sessions", web::http::methods::GET,
+                    &AuthController::handleSessions);
+    router->support("/auth/sessions", web::http::methods::DEL,
+                    &AuthController::handleLogoutEverywhere);
+    serverLogger->info(
+        fmt::v9::format("AuthController : Routed /auth/login, /auth/logout, "
+                        "/auth/refresh, /auth/sessions"));
+  }
+
 private:
   static std::shared_ptr<AuthController> instance;
   static std::mutex createMutex;
 
-  web::http::experimental::listener::http_listener loginListener;
-  web::http::experimental::listener::http_listener logoutListener;
-  web::uri loginUri;
-  web::uri logoutUri;
   AuthController() = delete;
 };
 
@@ -9,13 +9,22 @@ using namespace chat::module::exception;
 
 #include "../service/auth.hpp"
 #include "../service/base.hpp"
+#include "../service/version.hpp"
+
+#include "router.hpp"
 
 #include <spdlog/logger.h>
 
+#include <cpprest/http_headers.h>
 #include <cpprest/http_listener.h>
+#include <cpprest/http_msg.h>
 #include <cpprest/json.h>
 #include <cpprest/uri.h>
 
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <map>
 #include <memory>
 #include <string.h>
 #include <vector>
@@ -30,12 +39,16 @@ public:
   using SV = std::shared_ptr<service::BaseService>;
   using CONFIG = web::http::experimental::listener::http_listener_config;
 
-  virtual void listen() = 0;
+  using RT = std::shared_ptr<Router>;
+  using TARGET = service::VersionService::TARGET;
+
+  virtual void route(RT router) = 0;
 
 protected:
   CN conn;
   L serverLogger;
   SV authService;
+  SV versionService;
   web::uri baseUri;
   CONFIG config;
 
@@ -44,36 +57,231 @@ protected:
     return value;
   }
 
-  E authenticateAccess(web::json::value body) {
-    if (body.has_field("session-id") && body.has_field("session-token")) {
-      auto rawSessionId = bodyAt(body, "session-id");
+  struct Validator {
+    std::string etag;
+    std::string lastModified;
+  };
+
+  struct Cursor {
+    uint64_t after;
+    uint64_t limit;
+  };
+
+  static constexpr uint64_t defaultLimit = 100;
+  static constexpr uint64_t maxLimit = 1000;
+
+  static Cursor cursorOf(const std::map<std::string, std::string> &query) {
+    /**
+     * ?after=id&limit=N
+     * after : 이전 page의 next, 없으면 처음부터
+     * limit : 없으면 defaultLimit, 최대 maxLimit
+     */
+    auto cursor = Cursor{0, defaultLimit};
+    auto after = query.find("after");
+    if (after != query.end()) {
+      if ((after->second.empty()) ||
+          (module::isNumber(after->second) == false)) {
+        throw ControllerException(fmt::v9::format("not qualified after"));
+      }
+      cursor.after = std::stoull(after->second);
+    }
+    auto limit = query.find("limit");
+    if (limit != query.end()) {
+      if ((limit->second.empty()) ||
+          (module::isNumber(limit->second) == false)) {
+        throw ControllerException(fmt::v9::format("not qualified limit"));
+      }
+      cursor.limit =
+          std::clamp<uint64_t>(std::stoull(limit->second), 1, maxLimit);
+    }
+    return cursor;
+  }
+
+  Validator validatorOf(service::VersionService::Query query) {
+    /**
+     * entity를 읽지 않고 version만 조회해서 ETag, Last-Modified를 만든다
+     * entity가 없으면 validator도 없다 : If-None-Match: *도 맞지 않고
+     * handler의 NOT_FOUND로 간다 (RFC 9110 13.1.2)
+     */
+    auto version =
+        std::dynamic_pointer_cast<service::VersionService>(versionService)
+            ->find(query);
+    if (version.count == 0) {
+      return Validator{};
+    }
+    return validatorOf(version);
+  }
+
+  static Validator validatorOf(const dao::BaseRepository::Version &version) {
+    // lastModifiedAt은 초 단위라 같은 초 안의 두 번의 수정은 구분되지 않는다
+    char lastModified[32] = {0};
+    std::tm gmt{};
+    gmtime_r(&version.lastModifiedAt, &gmt);
+    std::strftime(lastModified, sizeof(lastModified),
+                  "%a, %d %b %Y %H:%M:%S GMT", &gmt);
+
+    return Validator{fmt::v9::format("W/\"{}-{}-{}\"", version.count,
+                                     version.lastModifiedAt,
+                                     version.createdAtSum),
+                     lastModified};
+  }
+
+  static bool notModified(web::http::http_request request,
+                          const Validator &validator) {
+    /**
+     * If-None-Match가 현재 ETag와 같으면 body 없이 304로 응답
+     * If-None-Match: W/"1-2-3", "4-5-6" or *
+     * weak comparison (RFC 9110 13.1.2)
+     */
+    auto headers = request.headers();
+    auto ifNoneMatch = headers.find("If-None-Match");
+    if (validator.etag.empty() || (ifNoneMatch == headers.end())) {
+      return false;
+    }
 
-      if (module::isNumber(rawSessionId) == false) {
-        throw NotAuthorizedException(fmt::v9::format("not authorized"));
+    auto opaqueOf = [](const std::string &tag) {
+      auto begin = tag.find_first_not_of(" \t");
+      if (begin == std::string::npos) {
+        return std::string{};
       }
+      auto opaque = tag.substr(begin, tag.find_last_not_of(" \t") - begin + 1);
+      if (opaque.rfind("W/", 0) == 0) {
+        opaque = opaque.substr(2);
+      }
+      return opaque;
+    };
+    auto current = opaqueOf(validator.etag);
+
+    bool matched = false;
+    size_t begin = 0;
+    auto &candidates = ifNoneMatch->second;
+    while ((matched == false) && (begin < candidates.size())) {
+      auto end = candidates.find(',', begin);
+      if (end == std::string::npos) {
+        end = candidates.size();
+      }
+      auto candidate = opaqueOf(candidates.substr(begin, end - begin));
+      matched = (candidate == "*") || (candidate == current);
+      begin = end + 1;
+    }
+    if (matched == false) {
+      return false;
+    }
+
+    web::http::http_response response(web::http::status_codes::NotModified);
+    response.headers().add("ETag", validator.etag);
+    response.headers().add("Last-Modified", validator.lastModified);
+    request.reply(response);
+    return true;
+  }
 
-      uint64_t sessionId = std::stoull(rawSessionId);
-      auto sessionToken = bodyAt(body, "session-token");
+  static void reply(web::http::http_request request, std::string route,
+                    const web::json::value &body,
+                    const Validator &validator = {}) {
+    /**
+     * body가 threshold 이상이고 client가 Accept-Encoding으로 허용하면
+     * gzip 또는 deflate로 압축해서 보낸다
+     * route 별로 응답 수, 압축 수, 압축 전후 byte, 압축 시간을 기록
+     */
+    auto metrics = module::Metrics::getInstance();
+    auto serialized = body.serialize();
+    auto encoding = module::compression::Encoding::IDENTITY;
 
-      if (std::dynamic_pointer_cast<service::AuthService>(authService)
-              ->verifyToken(sessionId, sessionToken) == false) {
-        throw NotAuthorizedException(fmt::v9::format("not authorized"));
+    if (serialized.size() >= module::compression::threshold) {
+      auto headers = request.headers();
+      auto acceptEncoding = headers.find("Accept-Encoding");
+      if (acceptEncoding != headers.end()) {
+        encoding = module::compression::negotiate(acceptEncoding->second);
       }
-      auto session =
-          std::dynamic_pointer_cast<service::AuthService>(authService)
-              ->getSession(sessionId);
-      auto entity =
-          std::dynamic_pointer_cast<dao::ServerSession>(session)->getValue();
-      return entity;
+    }
+
+    metrics->add(fmt::v9::format("compression.{}.responses", route));
+    metrics->add(fmt::v9::format("compression.{}.bytes_in", route),
+                 serialized.size());
+    if (encoding == module::compression::Encoding::IDENTITY) {
+      metrics->add(fmt::v9::format("compression.{}.bytes_out", route),
+                   serialized.size());
+      web::http::http_response response(web::http::status_codes::OK);
+      response.set_body(serialized, "application/json");
+      addValidator(response, validator);
+      request.reply(response);
+      return;
+    }
+
+    auto startedAt = std::chrono::steady_clock::now();
+    auto compressed = module::compression::compress(serialized, encoding);
+    int64_t elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+                          std::chrono::steady_clock::now() - startedAt)
+                          .count();
+
+    metrics->add(fmt::v9::format("compression.{}.compressed", route));
+    metrics->add(fmt::v9::format("compression.{}.bytes_out", route),
+                 compressed.size());
+    metrics->add(fmt::v9::format("compression.{}.us_total", route), elapsed);
+
+    web::http::http_response response(web::http::status_codes::OK);
+    response.set_body(std::move(compressed));
+    response.headers().set_content_type("application/json");
+    response.headers().add("Content-Encoding",
+                           module::compression::nameOf(encoding));
+    response.headers().add("Vary", "Accept-Encoding");
+    addValidator(response, validator);
+    request.reply(response);
+  }
+
+  static void addValidator(web::http::http_response &response,
+                           const Validator &validator) {
+    if (validator.etag.empty() == false) {
+      response.headers().add("ETag", validator.etag);
+      response.headers().add("Last-Modified", validator.lastModified);
+    }
+  }
+
+  static bool hasSession(const web::http::http_headers &headers) {
+    return headers.has("session-id") && headers.has("session-token");
+  }
 
+  E authenticateAccess(web::http::http_headers headers) {
+    /**
+     * header에 session이 있으면 body를 읽기 전에 검증
+     * header에 session이 없으면 nullptr -> body로 검증
+     */
+    if (hasSession(headers)) {
+      return authenticateSession(headers["session-id"],
+                                 headers["session-token"]);
+    }
+    return nullptr;
+  }
+
+  E authenticateAccess(web::json::value body) {
+    if (body.has_field("session-id") && body.has_field("session-token")) {
+      return authenticateSession(bodyAt(body, "session-id"),
+                                 bodyAt(body, "session-token"));
     } else {
       throw NotAuthorizedException(fmt::v9::format("not authorized"));
     }
   }
 
+  E authenticateSession(std::string rawSessionId, std::string sessionToken) {
+    if (module::isNumber(rawSessionId) == false) {
+      throw NotAuthorizedException(fmt::v9::format("not authorized"));
+    }
+
+    uint64_t sessionId = std::stoull(rawSessionId);
+
+    auto entity = std::dynamic_pointer_cast<service::AuthService>(authService)
+                      ->authenticate(sessionId, sessionToken);
+    if (entity == nullptr) {
+      throw NotAuthorizedException(fmt::v9::format("not authorized"));
+    }
+    return entity;
+  }
+
   BaseController(web::uri baseUri, L serverLogger, CN conn, CONFIG &config)
       : serverLogger(serverLogger), conn(conn), config(config),
-        authService(service::AuthService::getInstance(serverLogger, conn)) {}
+        authService(service::AuthService::getInstance(serverLogger, conn)),
+        versionService(
+            service::VersionService::getInstance(serverLogger, conn)) {}
   BaseController() = delete;
 };
 } // namespace chat::controller
\ No newline at end of file
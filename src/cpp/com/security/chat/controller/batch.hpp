@@ -0,0 +1,275 @@
+#pragma once
+
+#include "base.hpp"
+
+#include "../dao/company/entity.hpp"
+#include "../dao/participant/entity.hpp"
+#include "../dao/room/entity.hpp"
+#include "../dao/user/entity.hpp"
+
+#include "../dto/response.hpp"
+
+#include "../module/common.hpp"
+#include "../module/exception.hpp"
+using namespace chat::module::exception;
+
+#include "../service/auth.hpp"
+#include "../service/batch.hpp"
+
+#include <fmt/core.h>
+
+#include <cpprest/http_headers.h>
+#include <cpprest/http_msg.h>
+#include <cpprest/json.h>
+#include <cpprest/uri.h>
+
+#include <algorithm>
+#include <exception>
+#include <iterator>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace chat::controller {
+class BatchController : public BaseController {
+public:
+  using Q = service::BatchService::Query;
+  using TARGET = service::BatchService::TARGET;
+
+  static std::shared_ptr<BatchController>
+  getInstance(web::uri baseUri, L serverLogger, CN conn, CONFIG &config) {
+    std::lock_guard<std::mutex> lock(createMutex);
+    if (instance == nullptr) {
+      instance = std::make_shared<BatchController>(baseUri, serverLogger, conn,
+                                                   config);
+    }
+    return instance;
+  }
+  BatchController(web::uri baseUri, L serverLogger, CN conn, CONFIG &config)
+      : BaseController(baseUri, serverLogger, conn, config),
+        batchService(service::BatchService::getInstance(serverLogger, conn)) {}
+
+  static pplx::task<void> handleBatch(web::http::http_request request) {
+    /**
+     * 모든 사용자 가능
+     * /batch
+     * header
+     *  - session-id
+     *  - session-token
+     *
+     * body
+     *  - requests : ["/rooms/1", "/participants?room=1", "/users/2", ...]
+     *    GET only : /company/id, /users/id, /users?company=id, /rooms,
+     *               /rooms/id, /participants/id, /participants?room=id
+     *
+     * response - batch : [response of each request, in order]
+     */
+    auto headers = request.headers();
+    auto requestUri = request.absolute_uri();
+
+    try {
+      //권한 검증 : batch 전체에 대해 한 번만
+      auto sessionEntity = instance->authenticateAccess(headers);
+      auto body = co_await request.extract_json();
+      if (sessionEntity == nullptr) {
+        sessionEntity = instance->authenticateAccess(body);
+      }
+
+      // Authorization
+      if ((std::dynamic_pointer_cast<service::AuthService>(
+               instance->authService)
+               ->isUser(sessionEntity) == false) &&
+          (std::dynamic_pointer_cast<service::AuthService>(
+               instance->authService)
+               ->isCompany(sessionEntity) == false)) {
+        throw NotAuthorizedException(fmt::v9::format("not authorized"));
+      }
+
+      if ((body.has_field("requests") == false) ||
+          (body.at("requests").is_array() == false)) {
+        throw ControllerException(
+            fmt::v9::format("not qualified body: requests don't exist"));
+      }
+      auto &requests = body.at("requests").as_array();
+      if (requests.size() > maxRequests) {
+        throw ControllerException(fmt::v9::format(
+            "not qualified body: more than {} requests", maxRequests));
+      }
+
+      // main routine
+      auto paths = std::vector<std::string>{};
+      auto queries = std::vector<Q>{};
+      auto responses = std::vector<dto::Response>{};
+      auto parsed = std::vector<bool>{};
+      for (const auto &subRequest : requests) {
+        paths.emplace_back(module::trim(subRequest.serialize(), '"'));
+        try {
+          queries.emplace_back(parse(paths.back()));
+          parsed.emplace_back(true);
+        } catch (const ControllerException &e) {
+          parsed.emplace_back(false);
+        }
+      }
+
+      auto results =
+          std::dynamic_pointer_cast<service::BatchService>(
+              instance->batchService)
+              ->findAll(queries);
+
+      auto result = results.begin();
+      auto query = queries.begin();
+      for (size_t i = 0; i < paths.size(); ++i) {
+        auto msg = fmt::v9::format("BatchController[GET]({})", paths[i]);
+        if (parsed[i] == false) {
+          auto sendMsg = fmt::v9::format("{} : NOT_QUALIFIED_URI", msg);
+          responses.emplace_back(
+              dto::CODE::NOT_FOUND, sendMsg,
+              dto::ExceptionData(dto::CODE::NOT_FOUND, sendMsg));
+        } else if (result->empty()) {
+          auto sendMsg = fmt::v9::format("{} : NOT_FOUND", msg);
+          responses.emplace_back(
+              dto::CODE::NOT_FOUND, sendMsg,
+              dto::ExceptionData(dto::CODE::NOT_FOUND, sendMsg));
+        } else {
+          auto sendMsg = fmt::v9::format("{} : {}", msg, "ok");
+          responses.emplace_back(dto::CODE::OK, sendMsg,
+                                 serialize(*query, *result));
+        }
+        if (parsed[i]) {
+          ++result;
+          ++query;
+        }
+      }
+
+      auto msg =
+          fmt::v9::format("BatchController[POST]({})", requestUri.to_string());
+      auto logMsg = fmt::v9::format("{} : {}({})", msg, "ok", paths.size());
+      auto sendMsg = logMsg;
+
+      instance->serverLogger->info(logMsg);
+      reply(request, "/batch",
+            dto::Response(dto::CODE::OK, sendMsg, dto::BatchData(responses))
+                .serialize());
+    } catch (const NotAuthorizedException &e) {
+      auto msg =
+          fmt::v9::format("BatchController[POST]({})", requestUri.to_string());
+      auto logMsg = fmt::v9::format("{} : {}", msg, e.what());
+      auto sendMsg = fmt::v9::format("{} : NOT_AUTHRIZED", msg);
+
+      instance->serverLogger->error(logMsg);
+      auto data = dto::ExceptionData(dto::CODE::UNAUTHORIZED, sendMsg);
+      request.reply(
+          web::http::status_codes::OK,
+          dto::Response(dto::CODE::UNAUTHORIZED, sendMsg, data).serialize());
+    } catch (const std::exception &e) {
+      auto msg =
+          fmt::v9::format("BatchController[POST]({})", requestUri.to_string());
+      auto logMsg = fmt::v9::format("{} : {}", msg, e.what());
+      auto sendMsg = fmt::v9::format("{} : UNEXPECTED_ERROR", msg);
+
+      instance->serverLogger->error(logMsg);
+      auto data = dto::ExceptionData(dto::CODE::UNEXPECTED, sendMsg);
+      request.reply(
+          web::http::status_codes::OK,
+          dto::Response(dto::CODE::UNEXPECTED, sendMsg, data).serialize());
+    }
+  }
+
+  void route(RT router) override {
+    router->support("/batch", web::http::methods::POST,
+                    &BatchController::handleBatch);
+    serverLogger->info(fmt::v9::format("BatchController : Routed /batch"));
+  }
+
+private:
+  static Q parse(const std::string &path) {
+    // same uri as the GET handler of each controller
+    auto uri = web::uri(path);
+    auto splittedPath = web::uri::split_path(uri.path());
+    auto splittedQuery = web::uri::split_query(uri.query());
+
+    if ((splittedPath.size() == 2) && module::isNumber(splittedPath.back())) {
+      uint64_t id = std::stoull(splittedPath.back());
+      if (splittedPath.front() == "company") {
+        return Q{TARGET::COMPANY, id};
+      } else if (splittedPath.front() == "users") {
+        return Q{TARGET::USER, id};
+      } else if (splittedPath.front() == "rooms") {
+        return Q{TARGET::ROOM, id};
+      } else if (splittedPath.front() == "participants") {
+        return Q{TARGET::PARTICIPANT, id};
+      }
+    } else if (splittedPath.size() == 1) {
+      auto company = splittedQuery.find("company");
+      auto room = splittedQuery.find("room");
+      auto cursor = cursorOf(splittedQuery);
+      if (splittedPath.front() == "rooms") {
+        return Q{TARGET::ROOMS, 0, cursor.after, cursor.limit};
+      } else if ((splittedPath.front() == "users") &&
+                 (company != splittedQuery.end()) &&
+                 module::isNumber(company->second)) {
+        return Q{TARGET::USERS_IN_COMPANY, std::stoull(company->second),
+                 cursor.after, cursor.limit};
+      } else if ((splittedPath.front() == "participants") &&
+                 (room != splittedQuery.end()) &&
+                 module::isNumber(room->second)) {
+        return Q{TARGET::PARTICIPANTS_IN_ROOM, std::stoull(room->second),
+                 cursor.after, cursor.limit};
+      }
+    }
+    throw ControllerException(fmt::v9::format("not qualified uri"));
+  }
+
+  static dto::Data serialize(const Q &query, std::list<E> entities) {
+    auto target = query.target;
+    auto next = uint64_t(0);
+    if ((target == TARGET::USERS_IN_COMPANY) || (target == TARGET::ROOMS) ||
+        (target == TARGET::PARTICIPANTS_IN_ROOM)) {
+      auto page = service::BaseService::pageOf(entities, query.limit);
+      entities = std::move(page.entities);
+      next = page.next;
+    }
+
+    auto dataList = std::list<dto::Data>{};
+    std::transform(entities.begin(), entities.end(),
+                   std::back_inserter(dataList), [target](E entity) {
+                     switch (target) {
+                     case TARGET::COMPANY:
+                       return dto::Data(dto::CompanyData(
+                           *std::dynamic_pointer_cast<dao::Company>(entity)));
+                     case TARGET::USER:
+                     case TARGET::USERS_IN_COMPANY:
+                       return dto::Data(dto::UserData(
+                           *std::dynamic_pointer_cast<dao::User>(entity)));
+                     case TARGET::ROOM:
+                     case TARGET::ROOMS:
+                       return dto::Data(dto::RoomData(
+                           *std::dynamic_pointer_cast<dao::Room>(entity)));
+                     default:
+                       return dto::Data(dto::ParticipantData(
+                           *std::dynamic_pointer_cast<dao::Participant>(
+                               entity)));
+                     }
+                   });
+
+    // single lookup -> object, list lookup -> page (as the GET handlers)
+    if ((target == TARGET::COMPANY) || (target == TARGET::USER) ||
+        (target == TARGET::ROOM) || (target == TARGET::PARTICIPANT)) {
+      return dataList.front();
+    }
+    return dto::PageData(dataList, next);
+  }
+
+  static std::shared_ptr<BatchController> instance;
+  static std::mutex createMutex;
+
+  static constexpr size_t maxRequests = 32;
+
+  SV batchService;
+  BatchController() = delete;
+};
+
+std::shared_ptr<BatchController> BatchController::instance = nullptr;
+std::mutex BatchController::createMutex{};
+} // namespace chat::controller
@@ -26,7 +26,6 @@ using namespace chat::module::exception;
 #include <functional>
 #include <memory>
 #include <string>
-#include <thread>
 
 namespace chat::controller {
 class CompanyController : public BaseController {
@@ -43,14 +42,8 @@ public:
   CompanyController(web::uri baseUri, L serverLogger, CN conn, CONFIG &config)
       : BaseController(baseUri, serverLogger, conn, config),
         companyService(
-            service::CompanyService::getInstance(serverLogger, conn)) {
-    web::uri_builder builder{baseUri};
-    builder.set_path("/company");
-    this->listenUri = builder.to_uri();
-    this->listener = web::http::experimental::listener::http_listener{
-        this->listenUri, config};
-  }
-  static void handleGet(web::http::http_request request) {
+            service::CompanyService::getInstance(serverLogger, conn)) {}
+  static pplx::task<void> handleGet(web::http::http_request request) {
     // /company/id <- login한 모든 사용자는 접근 가능
     auto headers = request.headers();
     auto requestUri = request.absolute_uri();
@@ -58,9 +51,11 @@ public:
     auto splitedPath = web::http::uri::split_path(path);
 
     try {
-      auto body = request.extract_json().get();
-
-      auto sessionEntity = instance->authenticateAccess(body);
+      auto sessionEntity = instance->authenticateAccess(headers);
+      if (sessionEntity == nullptr) {
+        sessionEntity =
+            instance->authenticateAccess(co_await request.extract_json());
+      }
 
       // Authorization
       if ((std::dynamic_pointer_cast<service::AuthService>(
@@ -74,6 +69,15 @@ public:
 
       // main routine
       uint64_t companyId = std::stoull(splitedPath.back());
+
+      // conditional GET : version이 같으면 entity를 읽지 않는다
+      auto validator = instance->validatorOf({TARGET::COMPANY, companyId});
+      if (notModified(request, validator)) {
+        instance->serverLogger->info(
+            fmt::v9::format("CompanyController[GET]({}) : not modified",
+                            requestUri.to_string()));
+        co_return;
+      }
       auto company = std::dynamic_pointer_cast<service::CompanyService>(
                          instance->companyService)
                          ->findById(companyId);
@@ -85,8 +89,9 @@ public:
       instance->serverLogger->info(logMsg);
       auto data =
           dto::CompanyData(*std::dynamic_pointer_cast<dao::Company>(company));
-      request.reply(web::http::status_codes::OK,
-                    dto::Response(dto::CODE::OK, sendMsg, data).serialize());
+      reply(request, "/company",
+            dto::Response(dto::CODE::OK, sendMsg, data).serialize(),
+            validator);
     } catch (const NotAuthorizedException &e) {
       auto msg =
           fmt::v9::format("CompanyController[GET]({})", requestUri.to_string());
@@ -123,7 +128,7 @@ public:
     }
   }
 
-  static void handlePatch(web::http::http_request request) {
+  static pplx::task<void> handlePatch(web::http::http_request request) {
     //해당하는 company만 접근 가능!
     // /company/id + body에 name: [name], pw: [pw]
     auto headers = request.headers();
@@ -133,10 +138,12 @@ public:
 
     try {
       uint64_t companyId = std::stoull(splitedPath.back());
-      auto body = request.extract_json().get();
-
       //권한 검증
-      auto sessionEntity = instance->authenticateAccess(body);
+      auto sessionEntity = instance->authenticateAccess(headers);
+      auto body = co_await request.extract_json();
+      if (sessionEntity == nullptr) {
+        sessionEntity = instance->authenticateAccess(body);
+      }
 
       // Authorization
       if (std::dynamic_pointer_cast<service::AuthService>(instance->authService)
@@ -152,7 +159,8 @@ public:
       auto company = std::dynamic_pointer_cast<service::CompanyService>(
                          instance->companyService)
                          ->updateName(companyId, companyName);
-      company = std::dynamic_pointer_cast<service::CompanyService>(
+      // resumed once the password has been hashed and stored
+      company = co_await std::dynamic_pointer_cast<service::CompanyService>(
                     instance->companyService)
                     ->updatePw(companyId, companyPw);
 
@@ -213,39 +221,18 @@ public:
     }
   }
 
-  void listen() override {
-    std::function<void(web::http::http_request)> getHandler =
-        &CompanyController::handleGet;
-    std::function<void(web::http::http_request)> patchHandler =
-        &CompanyController::handlePatch;
-
-    listener.support(web::http::methods::GET, getHandler);
-    listener.support(web::http::methods::PATCH, patchHandler);
-
-    try {
-      listener.open()
-          .then([this]() {
-            serverLogger->info(
-                fmt::v9::format("CompanyController : Listening {}",
-                                this->listenUri.to_string()));
-          })
-          .wait();
-      while (true) {
-        std::this_thread::yield();
-      }
-    } catch (const std::exception &e) {
-      auto msg = fmt::v9::format("CompanyController : {}", e.what());
-      serverLogger->error(msg);
-      throw ControllerException(msg);
-    }
+  void route(RT router) override {
+    router->support("/company", web::http::methods::GET,
+                    &CompanyController::handleGet);
+    router->support("/company", web::http::methods::PATCH,
+                    &CompanyController::handlePatch);
+    serverLogger->info(fmt::v9::format("CompanyController : Routed /company"));
   }
 
 private:
   static std::shared_ptr<CompanyController> instance;
   static std::mutex createMutex;
 
-  web::http::experimental::listener::http_listener listener;
-  web::uri listenUri;
   SV companyService;
   CompanyController() = delete;
 };
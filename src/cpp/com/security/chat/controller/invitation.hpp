@@ -30,7 +30,6 @@ using namespace chat::module::exception;
 #include <iterator>
 #include <memory>
 #include <string>
-#include <thread>
 
 namespace chat::controller {
 class InvitationController : public BaseController {
@@ -50,15 +49,9 @@ public:
         invitationService(
             service::InvitationService::getInstance(serverLogger, conn)),
         participantService(
-            service::ParticipantService::getInstance(serverLogger, conn)) {
+            service::ParticipantService::getInstance(serverLogger, conn)) {}
 
-    web::uri_builder builder{baseUri};
-    this->listenUri = builder.set_path("/invitations").to_uri();
-    this->listener = web::http::experimental::listener::http_listener{
-        this->listenUri, config};
-  }
-
-  static void handleInvitation(web::http::http_request request) {
+  static pplx::task<void> handleInvitation(web::http::http_request request) {
     /**
      * host나 company가 초대!
      *
@@ -80,10 +73,12 @@ public:
     auto splittedQuery = web::uri::split_query(query);
 
     try {
-      auto body = request.extract_json().get();
-
       //권한 검증
-      auto sessionEntity = instance->authenticateAccess(body);
+      auto sessionEntity = instance->authenticateAccess(headers);
+      auto body = co_await request.extract_json();
+      if (sessionEntity == nullptr) {
+        sessionEntity = instance->authenticateAccess(body);
+      }
 
       // Authorization
 
@@ -223,9 +218,6 @@ public:
       auto invitation = std::dynamic_pointer_cast<service::InvitationService>(
                             instance->invitationService)
                             ->save(userId, roomId);
-      std::dynamic_pointer_cast<service::InvitationService>(
-          instance->invitationService)
-          ->sendEmail(invitation->getId());
 
       return std::make_unique<dto::InvitationData>(
           *std::dynamic_pointer_cast<dao::Invitation>(invitation));
@@ -262,35 +254,17 @@ public:
     }
   }
 
-  void listen() override {
-    std::function<void(web::http::http_request)> invitationhandler =
-        &InvitationController::handleInvitation;
-
-    listener.support(web::http::methods::POST, invitationhandler);
-    try {
-      listener.open()
-          .then([this]() {
-            serverLogger->info(
-                fmt::v9::format("InvitationController : Listening {}",
-                                this->listenUri.to_string()));
-          })
-          .wait();
-      while (true) {
-        std::this_thread::yield();
-      }
-    } catch (const std::exception &e) {
-      auto msg = fmt::v9::format("InvitationController : {}", e.what());
-      serverLogger->error(msg);
-      throw ControllerException(msg);
-    }
+  void route(RT router) override {
+    router->support("/invitations", web::http::methods::POST,
+                    &InvitationController::handleInvitation);
+    serverLogger->info(
+        fmt::v9::format("InvitationController : Routed /invitations"));
   }
 
 private:
   static std::shared_ptr<InvitationController> instance;
   static std::mutex createMutex;
 
-  web::http::experimental::listener::http_listener listener;
-  web::uri listenUri;
   SV invitationService;
   SV participantService;
   InvitationController() = delete;
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "base.hpp"
+
+#include "../dto/response.hpp"
+
+#include "../module/exception.hpp"
+#include "../module/metrics.hpp"
+using namespace chat::module::exception;
+
+#include "../service/auth.hpp"
+
+#include <fmt/core.h>
+
+#include <cpprest/http_msg.h>
+#include <cpprest/uri.h>
+
+#include <exception>
+#include <memory>
+#include <string>
+
+namespace chat::controller {
+class MetricsController : public BaseController {
+public:
+  static std::shared_ptr<MetricsController>
+  getInstance(web::uri baseUri, L serverLogger, CN conn, CONFIG &config) {
+    std::lock_guard<std::mutex> lock(createMutex);
+    if (instance == nullptr) {
+      instance = std::make_shared<MetricsController>(baseUri, serverLogger,
+                                                     conn, config);
+    }
+    return instance;
+  }
+  MetricsController(web::uri baseUri, L serverLogger, CN conn, CONFIG &config)
+      : BaseController(baseUri, serverLogger, conn, config),
+        metrics(module::Metrics::getInstance()) {}
+
+  static pplx::task<void> handleGet(web::http::http_request request) {
+    /**
+     * company only
+     * /metrics
+     * header
+     *  - session-id
+     *  - session-token
+     *
+     * response - name : value of every counter & gauge
+     */
+    auto headers = request.headers();
+    auto requestUri = request.absolute_uri();
+
+    try {
+      //권한 검증
+      auto sessionEntity = instance->authenticateAccess(headers);
+      if (sessionEntity == nullptr) {
+        sessionEntity =
+            instance->authenticateAccess(co_await request.extract_json());
+      }
+
+      // Authorization
+      if (std::dynamic_pointer_cast<service::AuthService>(instance->authService)
+              ->isCompany(sessionEntity) == false) {
+        throw NotAuthorizedException(fmt::v9::format("not authorized"));
+      }
+
+      // main routine
+      auto data = dto::MetricsData(instance->metrics->snapshot());
+
+      auto msg =
+          fmt::v9::format("MetricsController[GET]({})", requestUri.to_string());
+      auto logMsg = fmt::v9::format("{} : {}", msg, "ok");
+      auto sendMsg = logMsg;
+
+      instance->serverLogger->info(logMsg);
+      request.reply(web::http::status_codes::OK,
+                    dto::Response(dto::CODE::OK, sendMsg, data).serialize());
+    } catch (const NotAuthorizedException &e) {
+      auto msg =
+          fmt::v9::format("MetricsController[GET]({})", requestUri.to_string());
+      auto logMsg = fmt::v9::format("{} : {}", msg, e.what());
+      auto sendMsg = fmt::v9::format("{} : NOT_AUTHRIZED", msg);
+
+      instance->serverLogger->error(logMsg);
+      auto data = dto::ExceptionData(dto::CODE::UNAUTHORIZED, sendMsg);
+      request.reply(
+          web::http::status_codes::OK,
+          dto::Response(dto::CODE::UNAUTHORIZED, sendMsg, data).serialize());
+    } catch (const std::exception &e) {
+      auto msg =
+          fmt::v9::format("MetricsController[GET]({})", requestUri.to_string());
+      auto logMsg = fmt::v9::format("{} : {}", msg, e.what());
+      auto sendMsg = fmt::v9::format("{} : UNEXPECTED_ERROR", msg);
+
+      instance->serverLogger->error(logMsg);
+      auto data = dto::ExceptionData(dto::CODE::UNEXPECTED, sendMsg);
+      request.reply(
+          web::http::status_codes::OK,
+          dto::Response(dto::CODE::UNEXPECTED, sendMsg, data).serialize());
+    }
+  }
+
+  void route(RT router) override {
+    router->support("/metrics", web::http::methods::GET,
+                    &MetricsController::handleGet);
+    serverLogger->info(fmt::v9::format("MetricsController : Routed /metrics"));
+  }
+
+private:
+  static std::shared_ptr<MetricsController> instance;
+  static std::mutex createMutex;
+
+  std::shared_ptr<module::Metrics> metrics;
+  MetricsController() = delete;
+};
+
+std::shared_ptr<MetricsController> MetricsController::instance = nullptr;
+std::mutex MetricsController::createMutex{};
+} // namespace chat::controller
@@ -28,7 +28,6 @@ using namespace chat::module::exception;
 #include <iterator>
 #include <memory>
 #include <string>
-#include <thread>
 
 namespace chat::controller {
 class ParticipantController : public BaseController {
@@ -46,14 +45,9 @@ public:
                         CONFIG &config)
       : BaseController(baseUri, serverLogger, conn, config),
         participantService(
-            service::ParticipantService::getInstance(serverLogger, conn)) {
-    web::uri_builder builder{baseUri};
-    this->listenUri = builder.set_path("/participants").to_uri();
-    this->listener = web::http::experimental::listener::http_listener{
-        this->listenUri, config};
-  }
+            service::ParticipantService::getInstance(serverLogger, conn)) {}
 
-  static void handleGet(web::http::http_request request) {
+  static pplx::task<void> handleGet(web::http::http_request request) {
     /**
      * 모든 사용자 가능
      * /participants?room=id or /participants/id
@@ -70,9 +64,12 @@ public:
     auto path = requestUri.path();
 
     try {
-      auto body = request.extract_json().get();
       //권한 검증
-      auto sessionEntity = instance->authenticateAccess(body);
+      auto sessionEntity = instance->authenticateAccess(headers);
+      if (sessionEntity == nullptr) {
+        sessionEntity =
+            instance->authenticateAccess(co_await request.extract_json());
+      }
 
       // Authorization
       if ((std::dynamic_pointer_cast<service::AuthService>(
@@ -88,29 +85,51 @@ public:
       auto data = std::shared_ptr<dto::Data>{nullptr};
       auto splittedQuery = web::uri::split_query(query);
       auto splittedPath = web::uri::split_path(path);
+
+      auto validator = Validator{};
       if ((splittedQuery.find("room") != splittedQuery.end()) &&
           (splittedPath.size() == 1)) {
-        // /participants?room=id
+        // /participants?room=id&after=id&limit=N
         uint64_t roomId = std::stoull(splittedQuery.find("room")->second);
-        auto participantList =
-            std::dynamic_pointer_cast<service::ParticipantService>(
-                instance->participantService)
-                ->findAllInRoom(roomId);
+        auto cursor = cursorOf(splittedQuery);
+        auto page = std::dynamic_pointer_cast<service::ParticipantService>(
+                        instance->participantService)
+                        ->findAllInRoom(roomId, cursor.after, cursor.limit);
+
+        // conditional GET : page가 같으면 JSON을 만들지 않는다
+        validator = validatorOf(page.version);
+        if (notModified(request, validator)) {
+          instance->serverLogger->info(
+              fmt::v9::format("ParticipantController[GET]({}) : not modified",
+                              requestUri.to_string()));
+          co_return;
+        }
 
         auto participantDataList = std::list<dto::Data>{};
 
         std::transform(
-            participantList.begin(), participantList.end(),
+            page.entities.begin(), page.entities.end(),
             std::back_inserter(participantDataList), [](E user) {
               return dto::ParticipantData(
                   *std::dynamic_pointer_cast<dao::Participant>(user));
             });
-        data = std::make_unique<dto::ArrayData>(participantDataList);
+        data =
+            std::make_unique<dto::PageData>(participantDataList, page.next);
 
       } else if ((splittedPath.size() == 2) &&
                  module::isNumber(splittedPath.back())) {
         // /participants/id
         uint64_t participantId = std::stoull(splittedPath.back());
+
+        // conditional GET : version이 같으면 entity를 읽지 않는다
+        validator = instance->validatorOf({TARGET::PARTICIPANT, participantId});
+        if (notModified(request, validator)) {
+          instance->serverLogger->info(
+              fmt::v9::format("ParticipantController[GET]({}) : not modified",
+                              requestUri.to_string()));
+          co_return;
+        }
+
         auto participant =
             std::dynamic_pointer_cast<service::ParticipantService>(
                 instance->participantService)
@@ -127,8 +146,9 @@ public:
       auto sendMsg = logMsg;
 
       instance->serverLogger->info(logMsg);
-      request.reply(web::http::status_codes::OK,
-                    dto::Response(dto::CODE::OK, sendMsg, *data).serialize());
+      reply(request, "/participants",
+            dto::Response(dto::CODE::OK, sendMsg, *data).serialize(),
+            validator);
 
     } catch (const NotAuthorizedException &e) {
       auto msg = fmt::v9::format("ParticipantController[GET]({})",
@@ -170,7 +190,7 @@ public:
     // TODO
   }
 
-  static void handleSave(web::http::http_request request) {
+  static pplx::task<void> handleSave(web::http::http_request request) {
     /**
      * host or company만 가능
      * /participants?room=id
@@ -191,7 +211,6 @@ public:
     auto path = requestUri.path();
 
     try {
-      auto body = request.extract_json().get();
       auto splittedPath = web::uri::split_path(path);
       auto splittedQuery = web::uri::split_query(query);
 
@@ -203,7 +222,11 @@ public:
       uint64_t roomId = std::stoull(splittedQuery.find("room")->second);
 
       //권한 검증
-      auto sessionEntity = instance->authenticateAccess(body);
+      auto sessionEntity = instance->authenticateAccess(headers);
+      auto body = co_await request.extract_json();
+      if (sessionEntity == nullptr) {
+        sessionEntity = instance->authenticateAccess(body);
+      }
 
       if ((std::dynamic_pointer_cast<service::AuthService>(
                instance->authService)
@@ -296,7 +319,7 @@ public:
     }
   }
 
-  static void handleDelete(web::http::http_request request) {
+  static pplx::task<void> handleDelete(web::http::http_request request) {
     /**
      * host or company만 가능
      * /participants/id?room=id
@@ -314,7 +337,6 @@ public:
     auto path = requestUri.path();
 
     try {
-      auto body = request.extract_json().get();
       auto splittedPath = web::uri::split_path(path);
       auto splittedQuery = web::uri::split_query(query);
 
@@ -328,7 +350,11 @@ public:
       uint64_t roomId = std::stoull(splittedQuery.find("room")->second);
 
       //권한 검증
-      auto sessionEntity = instance->authenticateAccess(body);
+      auto sessionEntity = instance->authenticateAccess(headers);
+      if (sessionEntity == nullptr) {
+        sessionEntity =
+            instance->authenticateAccess(co_await request.extract_json());
+      }
 
       // Authorization
       if ((std::dynamic_pointer_cast<service::AuthService>(
@@ -408,45 +434,21 @@ public:
     }
   }
 
-  void listen() override {
-    std::function<void(web::http::http_request)> getHandler =
-        &ParticipantController::handleGet;
-    std::function<void(web::http::http_request)> updateHandler =
-        &ParticipantController::handleUpdate;
-    std::function<void(web::http::http_request)> saveHandler =
-        &ParticipantController::handleSave;
-    std::function<void(web::http::http_request)> deleteHandler =
-        &ParticipantController::handleDelete;
-
-    listener.support(web::http::methods::GET, getHandler);
-    // listener.support(web::http::methods::PATCH, updateHandler);
-    listener.support(web::http::methods::POST, saveHandler);
-    listener.support(web::http::methods::DEL, deleteHandler);
-
-    try {
-      listener.open()
-          .then([this]() {
-            serverLogger->info(
-                fmt::v9::format("ParticipantController : Listening {}",
-                                this->listenUri.to_string()));
-          })
-          .wait();
-      while (true) {
-        std::this_thread::yield();
-      }
-    } catch (const std::exception &e) {
-      auto msg = fmt::v9::format("ParticipantController : {}", e.what());
-      serverLogger->error(msg);
-      throw ControllerException(msg);
-    }
+  void route(RT router) override {
+    router->support("/participants", web::http::methods::GET,
+                    &ParticipantController::handleGet);
+    router->support("/participants", web::http::methods::POST,
+                    &ParticipantController::handleSave);
+    router->support("/participants", web::http::methods::DEL,
+                    &ParticipantController::handleDelete);
+    serverLogger->info(
+        fmt::v9::format("ParticipantController : Routed /participants"));
   }
 
 private:
   static std::shared_ptr<ParticipantController> instance;
   static std::mutex createMutex;
 
-  web::http::experimental::listener::http_listener listener;
-  web::uri listenUri;
   SV participantService;
   ParticipantController() = delete;
 };
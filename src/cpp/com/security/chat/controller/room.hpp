@@ -29,7 +29,6 @@ using namespace chat::module::exception;
 #include <iterator>
 #include <memory>
 #include <string>
-#include <thread>
 
 namespace chat::controller {
 class RoomController : public BaseController {
@@ -47,14 +46,9 @@ public:
       : BaseController(baseUri, serverLogger, conn, config),
         roomService(service::RoomService::getInstance(serverLogger, conn)),
         participantService(
-            service::ParticipantService::getInstance(serverLogger, conn)) {
-    web::uri_builder builder{baseUri};
-    this->listenUri = builder.set_path("/rooms").to_uri();
-    this->listener = web::http::experimental::listener::http_listener{
-        this->listenUri, config};
-  }
+            service::ParticipantService::getInstance(serverLogger, conn)) {}
 
-  static void handleGet(web::http::http_request request) {
+  static pplx::task<void> handleGet(web::http::http_request request) {
     /**
      * 모든 사용자 가능
      * /rooms/id or /rooms
@@ -69,10 +63,12 @@ public:
     auto path = requestUri.path();
 
     try {
-      auto body = request.extract_json().get();
-
       //권한 검증
-      auto sessionEntity = instance->authenticateAccess(body);
+      auto sessionEntity = instance->authenticateAccess(headers);
+      if (sessionEntity == nullptr) {
+        sessionEntity =
+            instance->authenticateAccess(co_await request.extract_json());
+      }
 
       // Authorization
       if ((std::dynamic_pointer_cast<service::AuthService>(
@@ -88,22 +84,45 @@ public:
       auto data = std::shared_ptr<dto::Data>{nullptr};
       auto splittedPath = web::uri::split_path(path);
 
+      auto validator = Validator{};
       if (splittedPath.back() == "rooms") {
-        auto roomList = std::dynamic_pointer_cast<service::RoomService>(
-                            instance->roomService)
-                            ->findAll();
+        // /rooms?after=id&limit=N
+        auto cursor = cursorOf(web::uri::split_query(requestUri.query()));
+        auto page = std::dynamic_pointer_cast<service::RoomService>(
+                        instance->roomService)
+                        ->findAll(cursor.after, cursor.limit);
+
+        // conditional GET : page가 같으면 JSON을 만들지 않는다
+        validator = validatorOf(page.version);
+        if (notModified(request, validator)) {
+          instance->serverLogger->info(
+              fmt::v9::format("RoomController[GET]({}) : not modified",
+                              requestUri.to_string()));
+          co_return;
+        }
+
         auto roomDataList = std::list<dto::Data>{};
-        std::transform(roomList.begin(), roomList.end(),
+        std::transform(page.entities.begin(), page.entities.end(),
                        std::back_inserter(roomDataList), [](E entity) {
                          return dto::RoomData(
                              *std::dynamic_pointer_cast<dao::Room>(entity));
                        });
-        data = std::make_unique<dto::ArrayData>(roomDataList);
+        data = std::make_unique<dto::PageData>(roomDataList, page.next);
 
       } else if ((splittedPath.size() == 2) &&
                  module::isNumber(splittedPath.back())) {
         // /rooms/id
         uint64_t roomId = std::stoull(splittedPath.back());
+
+        // conditional GET : version이 같으면 entity를 읽지 않는다
+        validator = instance->validatorOf({TARGET::ROOM, roomId});
+        if (notModified(request, validator)) {
+          instance->serverLogger->info(
+              fmt::v9::format("RoomController[GET]({}) : not modified",
+                              requestUri.to_string()));
+          co_return;
+        }
+
         auto room = std::dynamic_pointer_cast<service::RoomService>(
                         instance->roomService)
                         ->findById(roomId);
@@ -118,8 +137,9 @@ public:
       auto sendMsg = logMsg;
 
       instance->serverLogger->info(logMsg);
-      request.reply(web::http::status_codes::OK,
-                    dto::Response(dto::CODE::OK, sendMsg, *data).serialize());
+      reply(request, "/rooms",
+            dto::Response(dto::CODE::OK, sendMsg, *data).serialize(),
+            validator);
     } catch (const NotAuthorizedException &e) {
       auto msg =
           fmt::v9::format("RoomController[GET]({})", requestUri.to_string());
@@ -156,7 +176,7 @@ public:
     }
   }
 
-  static void handleUpdate(web::http::http_request request) {
+  static pplx::task<void> handleUpdate(web::http::http_request request) {
     /**
      * host거나, company만
      * /rooms/id
@@ -174,7 +194,6 @@ public:
     auto path = requestUri.path();
 
     try {
-      auto body = request.extract_json().get();
       auto splittedPath = web::uri::split_path(path);
       if ((splittedPath.size() != 2) ||
           (module::isNumber(splittedPath.back()) == false)) {
@@ -183,7 +202,11 @@ public:
       uint64_t roomId = std::stoull(splittedPath.back());
 
       //권한 검증
-      auto sessionEntity = instance->authenticateAccess(body);
+      auto sessionEntity = instance->authenticateAccess(headers);
+      auto body = co_await request.extract_json();
+      if (sessionEntity == nullptr) {
+        sessionEntity = instance->authenticateAccess(body);
+      }
 
       // Authorization
       if ((std::dynamic_pointer_cast<service::AuthService>(
@@ -268,7 +291,7 @@ public:
     }
   }
 
-  static void handleSave(web::http::http_request request) {
+  static pplx::task<void> handleSave(web::http::http_request request) {
     /**
      * 모든 사용자 가능(company X)
      * /rooms
@@ -286,7 +309,6 @@ public:
     auto path = requestUri.path();
 
     try {
-      auto body = request.extract_json().get();
       auto splittedPath = web::uri::split_path(path);
       if ((splittedPath.size() != 1)) {
         throw ControllerException(fmt::v9::format("not qualified uri"));
@@ -296,7 +318,11 @@ public:
       uint64_t userId = -1;
 
       //권한 검증
-      auto sessionEntity = instance->authenticateAccess(body);
+      auto sessionEntity = instance->authenticateAccess(headers);
+      auto body = co_await request.extract_json();
+      if (sessionEntity == nullptr) {
+        sessionEntity = instance->authenticateAccess(body);
+      }
 
       // Authorization
       if (std::dynamic_pointer_cast<service::AuthService>(instance->authService)
@@ -381,7 +407,7 @@ public:
     }
   }
 
-  static void handleDelete(web::http::http_request request) {
+  static pplx::task<void> handleDelete(web::http::http_request request) {
     /**
      * host거나 company만
      * /rooms/id
@@ -396,7 +422,6 @@ public:
     auto path = requestUri.path();
 
     try {
-      auto body = request.extract_json().get();
       auto splittedPath = web::uri::split_path(path);
       if ((splittedPath.size() != 2) ||
           (module::isNumber(splittedPath.back()) == false)) {
@@ -405,7 +430,11 @@ public:
       uint64_t roomId = std::stoull(splittedPath.back());
 
       //권한 검증
-      auto sessionEntity = instance->authenticateAccess(body);
+      auto sessionEntity = instance->authenticateAccess(headers);
+      if (sessionEntity == nullptr) {
+        sessionEntity =
+            instance->authenticateAccess(co_await request.extract_json());
+      }
 
       // Authorization
       if ((std::dynamic_pointer_cast<service::AuthService>(
@@ -476,44 +505,22 @@ public:
     }
   }
 
-  void listen() override {
-    std::function<void(web::http::http_request)> getHandler =
-        &RoomController::handleGet;
-    std::function<void(web::http::http_request)> updateHandler =
-        &RoomController::handleUpdate;
-    std::function<void(web::http::http_request)> saveHandler =
-        &RoomController::handleSave;
-    std::function<void(web::http::http_request)> deleteHandler =
-        &RoomController::handleDelete;
-
-    listener.support(web::http::methods::GET, getHandler);
-    listener.support(web::http::methods::PATCH, updateHandler);
-    listener.support(web::http::methods::POST, saveHandler);
-    listener.support(web::http::methods::DEL, deleteHandler);
-
-    try {
-      listener.open()
-          .then([this]() {
-            serverLogger->info(fmt::v9::format("RoomController : Listening {}",
-                                               this->listenUri.to_string()));
-          })
-          .wait();
-      while (true) {
-        std::this_thread::yield();
-      }
-    } catch (const std::exception &e) {
-      auto msg = fmt::v9::format("RoomController : {}", e.what());
-      serverLogger->error(msg);
-      throw ControllerException(msg);
-    }
+  void route(RT router) override {
+    router->support("/rooms", web::http::methods::GET,
+                    &RoomController::handleGet);
+    router->support("/rooms", web::http::methods::PATCH,
+                    &RoomController::handleUpdate);
+    router->support("/rooms", web::http::methods::POST,
+                    &RoomController::handleSave);
+    router->support("/rooms", web::http::methods::DEL,
+                    &RoomController::handleDelete);
+    serverLogger->info(fmt::v9::format("RoomController : Routed /rooms"));
   }
 
 private:
   static std::shared_ptr<RoomController> instance;
   static std::mutex createMutex;
 
-  web::http::experimental::listener::http_listener listener;
-  web::uri listenUri;
   SV roomService;
   SV participantService;
   RoomController() = delete;
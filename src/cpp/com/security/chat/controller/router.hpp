@@ -0,0 +1,277 @@
+#pragma once
+
+#include "../dto/response.hpp"
+
+#include "../module/common.hpp"
+#include "../module/coroutine.hpp"
+#include "../module/exception.hpp"
+#include "../module/limiter.hpp"
+#include "../module/metrics.hpp"
+#include "../module/worker.hpp"
+using namespace chat::module::exception;
+
+#include <fmt/core.h>
+
+#include <spdlog/logger.h>
+
+#include <cpprest/http_listener.h>
+#include <cpprest/http_msg.h>
+#include <cpprest/uri.h>
+
+#include <pplx/pplxtasks.h>
+
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace chat::controller {
+class Router {
+public:
+  using L = std::shared_ptr<spdlog::logger>;
+  using CONFIG = web::http::experimental::listener::http_listener_config;
+  using Handler = std::function<pplx::task<void>(web::http::http_request)>;
+  using POOL = std::shared_ptr<module::WorkerPool>;
+
+  static std::shared_ptr<Router> getInstance(web::uri baseUri, L serverLogger,
+                                             CONFIG &config, POOL pool,
+                                             uint64_t concurrency,
+                                             uint64_t capacity) {
+    std::lock_guard<std::mutex> lock(createMutex);
+    if (instance == nullptr) {
+      instance = std::make_shared<Router>(baseUri, serverLogger, config, pool,
+                                          concurrency, capacity);
+    }
+    return instance;
+  }
+  Router(web::uri baseUri, L serverLogger, CONFIG &config, POOL pool,
+         uint64_t concurrency, uint64_t capacity)
+      : serverLogger(serverLogger), baseUri(baseUri), pool(pool),
+        root(std::make_unique<Node>()), opened(false) {
+    this->listener =
+        web::http::experimental::listener::http_listener{baseUri, config};
+    // Routes without their own limit share the default lane
+    root->lane = std::make_shared<module::Lane>("default", pool, concurrency,
+                                                capacity);
+  }
+
+  void support(std::string prefix, web::http::method method,
+               Handler handler) {
+    /**
+     * Routes are compiled before the listener is opened.
+     * After open(), the trie is read-only and is walked without locking.
+     */
+    if (opened) {
+      throw ControllerException(
+          fmt::v9::format("Router : cannot add {} {} after open", method,
+                          prefix));
+    }
+    find(prefix)->handlers[method] = handler;
+  }
+
+  void limit(std::string prefix, uint64_t concurrency, uint64_t capacity) {
+    /**
+     * Requests under the prefix run at most `concurrency` at once and at most
+     * `capacity` more wait for a slot. The deepest limited prefix applies
+     */
+    if (opened) {
+      throw ControllerException(
+          fmt::v9::format("Router : cannot limit {} after open", prefix));
+    }
+    find(prefix)->lane =
+        std::make_shared<module::Lane>(prefix, pool, concurrency, capacity);
+  }
+
+  void throttle(std::string prefix, double rate, double burst) {
+    /**
+     * Each remote address, and each session sending a session-id header, may
+     * call under the prefix `rate` times per second with bursts of `burst`.
+     * The deepest throttled prefix applies; "/" sets the default
+     */
+    if (opened) {
+      throw ControllerException(
+          fmt::v9::format("Router : cannot throttle {} after open", prefix));
+    }
+    find(prefix)->throttle = std::make_shared<Throttle>(
+        Throttle{prefix, module::RateLimiter::Budget{rate, burst},
+                 module::Metrics::getInstance()->at(
+                     fmt::v9::format("ratelimit.{}.rejected", prefix))});
+  }
+
+  void open() {
+    std::function<void(web::http::http_request)> dispatchHandler =
+        [this](web::http::http_request request) { dispatch(request); };
+    listener.support(dispatchHandler);
+
+    try {
+      opened = true;
+      listener.open()
+          .then([this]() {
+            serverLogger->info(fmt::v9::format("Router : Listening {}",
+                                               baseUri.to_string()));
+          })
+          .wait();
+    } catch (const std::exception &e) {
+      auto msg = fmt::v9::format("Router : {}", e.what());
+      serverLogger->error(msg);
+      throw ControllerException(msg);
+    }
+  }
+
+  void close() {
+    try {
+      listener.close()
+          .then([this]() {
+            serverLogger->info(
+                fmt::v9::format("Router : Closed {}", baseUri.to_string()));
+          })
+          .wait();
+      // Let the handlers already admitted run to completion
+      pool->stop();
+    } catch (const std::exception &e) {
+      auto msg = fmt::v9::format("Router : {}", e.what());
+      serverLogger->error(msg);
+      throw ControllerException(msg);
+    }
+  }
+
+private:
+  struct Throttle {
+    std::string prefix;
+    module::RateLimiter::Budget budget;
+    module::Metrics::V &rejected;
+  };
+
+  struct Node {
+    std::unordered_map<std::string, std::unique_ptr<Node>> children;
+    std::unordered_map<web::http::method, Handler> handlers;
+    std::shared_ptr<module::Lane> lane;
+    std::shared_ptr<Throttle> throttle;
+  };
+
+  Node *find(const std::string &prefix) {
+    auto node = root.get();
+    for (const auto &segment : web::uri::split_path(prefix)) {
+      auto &child = node->children[segment];
+      if (child == nullptr) {
+        child = std::make_unique<Node>();
+      }
+      node = child.get();
+    }
+    return node;
+  }
+
+  void dispatch(web::http::http_request request) {
+    // The deepest registered prefix wins: /rooms/1 -> /rooms
+    auto requestUri = request.absolute_uri();
+    const Node *matched = nullptr;
+    auto lane = root->lane;
+    auto throttle = root->throttle;
+    auto node = root.get();
+    for (const auto &segment : web::uri::split_path(requestUri.path())) {
+      auto child = node->children.find(segment);
+      if (child == node->children.end()) {
+        break;
+      }
+      node = child->second.get();
+      if (node->handlers.empty() == false) {
+        matched = node;
+      }
+      if (node->lane != nullptr) {
+        lane = node->lane;
+      }
+      if (node->throttle != nullptr) {
+        throttle = node->throttle;
+      }
+    }
+
+    if (matched == nullptr) {
+      reject(request, dto::CODE::NOT_FOUND, "NOT_FOUND");
+      return;
+    }
+    auto handler = matched->handlers.find(request.method());
+    if (handler == matched->handlers.end()) {
+      reject(request, dto::CODE::NOT_FOUND, "NOT_FOUND");
+      return;
+    }
+
+    // Rate limit before any body is read or any DB work is queued
+    if ((throttle != nullptr) && (admit(request, *throttle) == false)) {
+      throttle->rejected.fetch_add(1, std::memory_order_relaxed);
+      reject(request, dto::CODE::TOO_MANY_REQUESTS, "TOO_MANY_REQUESTS");
+      return;
+    }
+
+    // The listener thread only enqueues; the handler starts on the pool.
+    // Its lane slot is released once the handler's task completes
+    if (lane->submit(
+            [this, handler = handler->second,
+             request](module::Lane::Done done) {
+              handler(request).then([this, done](pplx::task<void> handled) {
+                try {
+                  handled.get();
+                } catch (const std::exception &e) {
+                  serverLogger->error(
+                      fmt::v9::format("Router : {}", e.what()));
+                }
+                done();
+              });
+            },
+            [this, request]() {
+              // admitted, but the pool stopped before it could start
+              reject(request, dto::CODE::SERVICE_UNAVAILABLE,
+                     "SERVICE_UNAVAILABLE");
+            }) == false) {
+      reject(request, dto::CODE::TOO_MANY_REQUESTS, "TOO_MANY_REQUESTS");
+    }
+  }
+
+  bool admit(web::http::http_request request, const Throttle &throttle) {
+    if (limiter.acquire(fmt::v9::format("ip {} {}", throttle.prefix,
+                                        request.remote_address()),
+                        throttle.budget) == false) {
+      return false;
+    }
+    auto headers = request.headers();
+    auto sessionId = headers.find("session-id");
+    if (sessionId == headers.end()) {
+      return true;
+    }
+    return limiter.acquire(fmt::v9::format("session {} {}", throttle.prefix,
+                                           sessionId->second),
+                           throttle.budget);
+  }
+
+  void reject(web::http::http_request request, dto::CODE code,
+              std::string reason) {
+    auto msg = fmt::v9::format("Router[{}]({})", request.method(),
+                               request.absolute_uri().to_string());
+    auto sendMsg = fmt::v9::format("{} : {}", msg, reason);
+
+    serverLogger->error(sendMsg);
+    auto data = dto::ExceptionData(code, sendMsg);
+    request.reply(web::http::status_codes::OK,
+                  dto::Response(code, sendMsg, data).serialize());
+  }
+
+  static std::shared_ptr<Router> instance;
+  static std::mutex createMutex;
+
+  L serverLogger;
+  web::uri baseUri;
+  POOL pool;
+  web::http::experimental::listener::http_listener listener;
+  std::unique_ptr<Node> root;
+  module::RateLimiter limiter;
+  std::atomic<bool> opened;
+
+  Router() = delete;
+};
+
+std::shared_ptr<Router> Router::instance = nullptr;
+std::mutex Router::createMutex{};
+} // namespace chat::controller
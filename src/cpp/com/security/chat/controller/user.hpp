@@ -28,7 +28,6 @@ using namespace chat::module::exception;
 #include <iterator>
 #include <memory>
 #include <string>
-#include <thread>
 
 namespace chat::controller {
 class UserController : public BaseController {
@@ -44,23 +43,20 @@ public:
   }
   UserController(web::uri baseUri, L serverLogger, CN conn, CONFIG &config)
       : BaseController(baseUri, serverLogger, conn, config),
-        userService(service::UserService::getInstance(serverLogger, conn)) {
-    web::uri_builder builder{baseUri};
-    this->listenUri = builder.set_path("/users").to_uri();
-    this->listener = web::http::experimental::listener::http_listener{
-        this->listenUri, config};
-  }
+        userService(service::UserService::getInstance(serverLogger, conn)) {}
 
-  static void handleGet(web::http::http_request request) {
+  static pplx::task<void> handleGet(web::http::http_request request) {
     auto headers = request.headers();
     auto requestUri = request.absolute_uri();
     auto query = requestUri.query();
     auto path = requestUri.path();
 
     try {
-      auto body = request.extract_json().get();
-
-      auto sessionEntity = instance->authenticateAccess(body);
+      auto sessionEntity = instance->authenticateAccess(headers);
+      if (sessionEntity == nullptr) {
+        sessionEntity =
+            instance->authenticateAccess(co_await request.extract_json());
+      }
 
       if ((std::dynamic_pointer_cast<service::AuthService>(
                instance->authService)
@@ -75,25 +71,49 @@ public:
       auto data = std::shared_ptr<dto::Data>{nullptr};
       auto splittedQuery = web::uri::split_query(query);
       auto splittedPath = web::uri::split_path(path);
+
+      auto validator = Validator{};
       if ((splittedQuery.find("company") != splittedQuery.end()) &&
           (splittedPath.back() == "users")) {
-        // /users?company=id
+        // /users?company=id&after=id&limit=N
         uint64_t companyId = std::stoull(splittedQuery.find("company")->second);
-        auto userList = std::dynamic_pointer_cast<service::UserService>(
-                            instance->userService)
-                            ->findAllInCompany(companyId);
+        auto cursor = cursorOf(splittedQuery);
+        auto page = std::dynamic_pointer_cast<service::UserService>(
+                        instance->userService)
+                        ->findAllInCompany(companyId, cursor.after,
+                                           cursor.limit);
+
+        // conditional GET : page가 같으면 JSON을 만들지 않는다
+        validator = validatorOf(page.version);
+        if (notModified(request, validator)) {
+          instance->serverLogger->info(
+              fmt::v9::format("UserController[GET]({}) : not modified",
+                              requestUri.to_string()));
+          co_return;
+        }
+
         auto userDataList = std::list<dto::Data>{};
 
-        std::transform(userList.begin(), userList.end(),
+        std::transform(page.entities.begin(), page.entities.end(),
                        std::back_inserter(userDataList), [](E user) {
                          return dto::UserData(
                              *std::dynamic_pointer_cast<dao::User>(user));
                        });
-        data = std::make_unique<dto::ArrayData>(userDataList);
+        data = std::make_unique<dto::PageData>(userDataList, page.next);
 
       } else if (splittedQuery.find("company") == splittedQuery.end()) {
         // /users/id
         uint64_t userId = std::stoull(splittedPath.back());
+
+        // conditional GET : version이 같으면 entity를 읽지 않는다
+        validator = instance->validatorOf({TARGET::USER, userId});
+        if (notModified(request, validator)) {
+          instance->serverLogger->info(
+              fmt::v9::format("UserController[GET]({}) : not modified",
+                              requestUri.to_string()));
+          co_return;
+        }
+
         auto user = std::dynamic_pointer_cast<service::UserService>(
                         instance->userService)
                         ->findById(userId);
@@ -109,8 +129,9 @@ public:
       auto sendMsg = logMsg;
 
       instance->serverLogger->info(logMsg);
-      request.reply(web::http::status_codes::OK,
-                    dto::Response(dto::CODE::OK, sendMsg, *data).serialize());
+      reply(request, "/users",
+            dto::Response(dto::CODE::OK, sendMsg, *data).serialize(),
+            validator);
     } catch (const NotAuthorizedException &e) {
       auto msg =
           fmt::v9::format("UserController[GET]({})", requestUri.to_string());
@@ -147,7 +168,7 @@ public:
     }
   }
 
-  static void handleUpdate(web::http::http_request request) {
+  static pplx::task<void> handleUpdate(web::http::http_request request) {
     /**
      * this-user or company only
      *
@@ -168,10 +189,13 @@ public:
     auto path = requestUri.path();
 
     try {
-      auto body = request.extract_json().get();
       uint64_t userId = std::stoull(web::uri::split_path(path).back());
       //권한 검증
-      auto sessionEntity = instance->authenticateAccess(body);
+      auto sessionEntity = instance->authenticateAccess(headers);
+      auto body = co_await request.extract_json();
+      if (sessionEntity == nullptr) {
+        sessionEntity = instance->authenticateAccess(body);
+      }
 
       if ((std::dynamic_pointer_cast<service::AuthService>(
                instance->authService)
@@ -188,9 +212,10 @@ public:
       auto role = bodyAt(body, "role");
       auto password = bodyAt(body, "password");
 
-      auto user =
-          std::dynamic_pointer_cast<service::UserService>(instance->userService)
-              ->update(userId, name, role, email, password);
+      // resumed once the password has been hashed and stored
+      auto user = co_await std::dynamic_pointer_cast<service::UserService>(
+                      instance->userService)
+                      ->update(userId, name, role, email, password);
       auto data = dto::UserData(*std::dynamic_pointer_cast<dao::User>(user));
 
       auto msg =
@@ -259,7 +284,7 @@ public:
     }
   }
 
-  static void handleSave(web::http::http_request request) {
+  static pplx::task<void> handleSave(web::http::http_request request) {
     /**
      * company only
      *
@@ -277,11 +302,14 @@ public:
     auto requestUri = request.absolute_uri();
 
     try {
-      auto body = request.extract_json().get();
       uint64_t companyId = -1;
 
       //권한 검증
-      auto sessionEntity = instance->authenticateAccess(body);
+      auto sessionEntity = instance->authenticateAccess(headers);
+      auto body = co_await request.extract_json();
+      if (sessionEntity == nullptr) {
+        sessionEntity = instance->authenticateAccess(body);
+      }
       if (std::dynamic_pointer_cast<service::AuthService>(instance->authService)
               ->isCompany(sessionEntity) == false) {
         throw NotAuthorizedException(fmt::v9::format("not authorized"));
@@ -295,9 +323,10 @@ public:
       auto role = bodyAt(body, "role");
       auto password = bodyAt(body, "password");
 
-      auto user =
-          std::dynamic_pointer_cast<service::UserService>(instance->userService)
-              ->save(name, companyId, role, email, password);
+      // resumed once the password has been hashed and stored
+      auto user = co_await std::dynamic_pointer_cast<service::UserService>(
+                      instance->userService)
+                      ->save(name, companyId, role, email, password);
       auto data = dto::UserData(*std::dynamic_pointer_cast<dao::User>(user));
 
       auto msg =
@@ -355,7 +384,7 @@ public:
     }
   }
 
-  static void handleDelete(web::http::http_request request) {
+  static pplx::task<void> handleDelete(web::http::http_request request) {
     /**
      * company or this-user only
      *
@@ -382,11 +411,14 @@ public:
     auto path = requestUri.path();
 
     try {
-      auto body = request.extract_json().get();
       uint64_t userId = std::stoull(web::uri::split_path(path).back());
 
       //권한 검증
-      auto sessionEntity = instance->authenticateAccess(body);
+      auto sessionEntity = instance->authenticateAccess(headers);
+      if (sessionEntity == nullptr) {
+        sessionEntity =
+            instance->authenticateAccess(co_await request.extract_json());
+      }
 
       if ((std::dynamic_pointer_cast<service::AuthService>(
                instance->authService)
@@ -458,44 +490,22 @@ public:
     }
   }
 
-  void listen() override {
-    std::function<void(web::http::http_request)> getHandler =
-        &UserController::handleGet;
-    std::function<void(web::http::http_request)> updateHandler =
-        &UserController::handleUpdate;
-    std::function<void(web::http::http_request)> saveHandler =
-        &UserController::handleSave;
-    std::function<void(web::http::http_request)> deleteHandler =
-        &UserController::handleDelete;
-
-    listener.support(web::http::methods::GET, getHandler);
-    listener.support(web::http::methods::PATCH, updateHandler);
-    listener.support(web::http::methods::POST, saveHandler);
-    listener.support(web::http::methods::DEL, deleteHandler);
-
-    try {
-      listener.open()
-          .then([this]() {
-            serverLogger->info(fmt::v9::format("UserController : Listening {}",
-                                               this->listenUri.to_string()));
-          })
-          .wait();
-      while (true) {
-        std::this_thread::yield();
-      }
-    } catch (const std::exception &e) {
-      auto msg = fmt::v9::format("UserController : {}", e.what());
-      serverLogger->error(msg);
-      throw ControllerException(msg);
-    }
+  void route(RT router) override {
+    router->support("/users", web::http::methods::GET,
+                    &UserController::handleGet);
+    router->support("/users", web::http::methods::PATCH,
+                    &UserController::handleUpdate);
+    router->support("/users", web::http::methods::POST,
+                    &UserController::handleSave);
+    router->support("/users", web::http::methods::DEL,
+                    &UserController::handleDelete);
+    serverLogger->info(fmt::v9::format("UserController : Routed /users"));
   }
 
 private:
   static std::shared_ptr<UserController> instance;
   static std::mutex createMutex;
 
-  web::http::experimental::listener::http_listener listener;
-  web::uri listenUri;
   SV userService;
   UserController() = delete;
 };
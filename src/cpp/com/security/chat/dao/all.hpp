@@ -2,6 +2,7 @@
 
 #include "company/entity.hpp"
 #include "invitation/entity.hpp"
+#include "mail/entity.hpp"
 #include "participant/entity.hpp"
 #include "password/entity.hpp"
 #include "room/entity.hpp"
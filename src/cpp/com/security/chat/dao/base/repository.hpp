@@ -24,6 +24,18 @@ public:
   virtual R update(mysqlx::Session &session, E entity) = 0;
   virtual bool remove(mysqlx::Session &session, E entity) = 0;
 
+  struct Version {
+    /**
+     * Fingerprint of the rows matching a condition, read without
+     * materializing them.
+     * An update moves lastModifiedAt, an insert or delete moves count &
+     * createdAtSum
+     */
+    uint64_t count;
+    time_t lastModifiedAt;
+    uint64_t createdAtSum;
+  };
+
 protected:
   std::mutex sessionMutex;
   L repoLogger;
@@ -41,6 +53,21 @@ protected:
     return time_t(uint32_t(value));
   }
 
+  Version findVersionBy(mysqlx::Session &session, std::string condition) {
+    auto row =
+        getTable(session, tableName)
+            .select("COUNT(*)",
+                    "CAST(IFNULL(MAX(UNIX_TIMESTAMP(last_modified_at)), 0) AS "
+                    "UNSIGNED)",
+                    "CAST(IFNULL(SUM(UNIX_TIMESTAMP(created_at)), 0) AS "
+                    "UNSIGNED)")
+            .where(condition)
+            .execute()
+            .fetchOne();
+    return Version{uint64_t(row.get(0)), convertToTimeT(row.get(1)),
+                   uint64_t(row.get(2))};
+  }
+
   mysqlx::Table getTable(mysqlx::Session &session, const std::string name) {
     return session.getDefaultSchema().getTable(name, true);
   }
@@ -46,6 +46,10 @@ public:
     return findBy(session, fmt::v9::format("company_id={}", id));
   }
 
+  Version findVersionById(mysqlx::Session &session, uint64_t id) {
+    return findVersionBy(session, fmt::v9::format("company_id={}", id));
+  }
+
   R save(mysqlx::Session &session, E entity) override {
     std::lock_guard<std::mutex> lock(sessionMutex);
     try {
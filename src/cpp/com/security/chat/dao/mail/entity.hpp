@@ -0,0 +1,64 @@
+#pragma once
+
+#include "../base/entity.hpp"
+
+#include "../../module/common.hpp"
+
+#include <fmt/core.h>
+
+#include <chrono>
+#include <ctime>
+#include <string>
+
+namespace chat::dao {
+
+class Mail : public Base {
+  /**
+   * A row of the outbound mail queue
+   * nextAt : when a worker may (re)try it. A worker that claims the row
+   *          pushes it forward by a lease, so a crashed sender is retried
+   * attempts : delivery attempts so far
+   */
+public:
+  std::string getRecipient() const { return this->recipient; }
+  void setRecipient(std::string recipient) { this->recipient = recipient; }
+
+  std::string getSubject() const { return this->subject; }
+  void setSubject(std::string subject) { this->subject = subject; }
+
+  std::string getBody() const { return this->body; }
+  void setBody(std::string body) { this->body = body; }
+
+  uint32_t getAttempts() const { return this->attempts; }
+  void setAttempts(uint32_t attempts) { this->attempts = attempts; }
+
+  time_t getNextAt() const { return this->nextAt; }
+  void setNextAt(time_t nextAt) { this->nextAt = nextAt; }
+
+  Mail(std::string recipient, std::string subject, std::string body,
+       uint32_t attempts = 0, time_t nextAt = 0, uint64_t id = -1,
+       time_t createdAt = 0, time_t lastModifiedAt = 0)
+      : Base(id, createdAt, lastModifiedAt), recipient(recipient),
+        subject(subject), body(body), attempts(attempts), nextAt(nextAt) {}
+
+  operator std::string() const {
+    // the body carries invitation codes, so it is never printed
+    return fmt::v9::format(
+        "Mail(id={}, recipient={}, subject={}, attempts={}, nextAt={}, "
+        "createdAt={}, lastModifiedAt={})",
+        id, recipient, subject, attempts,
+        module::convertToLocalTimeString(nextAt),
+        module::convertToLocalTimeString(createdAt),
+        module::convertToLocalTimeString(lastModifiedAt));
+  }
+
+private:
+  std::string recipient;
+  std::string subject;
+  std::string body;
+  uint32_t attempts;
+  time_t nextAt;
+
+  Mail() = delete;
+};
+} // namespace chat::dao
@@ -0,0 +1,178 @@
+#pragma once
+
+#include "../base/entity.hpp"
+#include "../base/repository.hpp"
+#include "./entity.hpp"
+
+#include "../../module/all.hpp"
+using namespace chat::module::exception;
+
+#include <mysqlx/xdevapi.h>
+
+#include <fmt/core.h>
+
+#include <exception>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace chat::dao {
+
+class MailRepository : public BaseRepository {
+public:
+  static std::shared_ptr<MailRepository> getInstance(L repoLogger) {
+    std::lock_guard<std::mutex> lock(createMutex);
+    if (instance == nullptr) {
+      instance = std::make_shared<MailRepository>(repoLogger);
+    }
+    return instance;
+  }
+
+  MailRepository(L repoLogger) : BaseRepository(repoLogger, "outbox_mail"){};
+
+  R findById(mysqlx::Session &session, uint64_t id) override {
+    auto mails = findAllBy(session, fmt::v9::format("mail_id={}", id));
+    if (mails.empty()) {
+      return nullptr;
+    }
+    return mails.front();
+  }
+
+  std::list<R> claimDue(mysqlx::Session &session, time_t now, time_t lease,
+                        uint64_t limit) {
+    /**
+     * Up to `limit` rows due at `now`, oldest first. Their nextAt is moved
+     * to now + lease and attempts is counted up before the caller commits,
+     * so other workers (on this node or another) skip them meanwhile.
+     * Rows locked by another claim are skipped rather than waited for
+     */
+    const auto condition = fmt::v9::format(
+        "next_at <= '{}'", module::convertToLocalTimeString(now));
+    auto mails = findAllBy(session, condition, limit, true);
+    for (auto &entity : mails) {
+      auto mail = std::dynamic_pointer_cast<Mail>(entity);
+      mail->setAttempts(mail->getAttempts() + 1);
+      mail->setNextAt(now + lease);
+      update(session, mail);
+    }
+    return mails;
+  }
+
+  R save(mysqlx::Session &session, E entity) override {
+    std::lock_guard<std::mutex> lock(sessionMutex);
+    try {
+      auto tableInsert = getTable(session, tableName)
+                             .insert("recipient", "subject", "body",
+                                     "attempts", "next_at");
+      const auto mail = std::dynamic_pointer_cast<Mail>(entity);
+      // the recipient ends up in an SMTP command line
+      if (!module::secure::verifyEmail(mail->getRecipient())) {
+        const auto msg =
+            fmt::v9::format("MailRepository: recipient={} is invalid format",
+                            mail->getRecipient());
+        repoLogger->error(msg);
+        throw EntityException(msg);
+      }
+      const auto row = mysqlx::Row(
+          mail->getRecipient(), mail->getSubject(), mail->getBody(),
+          mail->getAttempts(),
+          module::convertToLocalTimeString(mail->getNextAt()));
+      const auto result = tableInsert.values(row).execute();
+      return findById(session, result.getAutoIncrementValue());
+    } catch (const std::exception &e) {
+      auto msg = fmt::v9::format("MailRepository: {}", e.what());
+      repoLogger->error(msg);
+      throw EntityException(msg);
+    }
+  }
+
+  R update(mysqlx::Session &session, E entity) override {
+    /**
+     * Only the delivery state changes after a mail is queued
+     * The entity is returned as is instead of being read back, since a
+     * claim updates a whole batch
+     */
+    std::lock_guard<std::mutex> lock(sessionMutex);
+    try {
+      auto tableUpdate = getTable(session, tableName).update();
+      const auto mail = std::dynamic_pointer_cast<Mail>(entity);
+      const auto condition = fmt::v9::format("mail_id={}", mail->getId());
+      const auto result =
+          tableUpdate.set("attempts", mail->getAttempts())
+              .set("next_at",
+                   module::convertToLocalTimeString(mail->getNextAt()))
+              .set("last_modified_at",
+                   module::convertToLocalTimeString(module::getCurrentTime()))
+              .where(condition)
+              .execute();
+      return entity;
+    } catch (const std::exception &e) {
+      auto msg = fmt::v9::format("MailRepository: {}", e.what());
+      repoLogger->error(msg);
+      throw EntityException(msg);
+    }
+  }
+
+  bool remove(mysqlx::Session &session, E entity) override {
+    std::lock_guard<std::mutex> lock(sessionMutex);
+    try {
+      auto tableRemove = getTable(session, tableName).remove();
+      const auto condition = fmt::v9::format("mail_id={}", entity->getId());
+      const auto result = tableRemove.where(condition).execute();
+      return true;
+    } catch (const std::exception &e) {
+      auto msg = fmt::v9::format("MailRepository: {}", e.what());
+      repoLogger->error(msg);
+      throw EntityException(msg);
+    }
+  }
+
+private:
+  static std::shared_ptr<MailRepository> instance;
+  static std::mutex createMutex;
+  MailRepository() = delete;
+
+  std::list<R> findAllBy(mysqlx::Session &session, std::string condition,
+                         uint64_t limit = 0, bool claim = false) {
+    try {
+      auto tableSelect =
+          getTable(session, tableName)
+              .select("recipient", "subject", "body", "attempts",
+                      getUnixTimestampFormatter("next_at"), "mail_id",
+                      getUnixTimestampFormatter("created_at"),
+                      getUnixTimestampFormatter("last_modified_at"));
+      tableSelect.where(condition);
+      if (limit > 0) {
+        tableSelect.orderBy("next_at").limit(limit);
+      }
+      if (claim) {
+        // SELECT ... FOR UPDATE SKIP LOCKED
+        tableSelect.lockExclusive(mysqlx::LockContention::SKIP_LOCKED);
+      }
+      auto result = tableSelect.execute();
+
+      auto rawList = result.fetchAll();
+      auto mailList = std::list<R>{};
+      for (auto &row : rawList) {
+        if (row.isNull()) {
+          continue;
+        }
+        mailList.emplace_back(R(new Mail(
+            std::string(row.get(0)), std::string(row.get(1)),
+            std::string(row.get(2)), uint32_t(uint64_t(row.get(3))),
+            convertToTimeT(row.get(4)), uint64_t(row.get(5)),
+            convertToTimeT(row.get(6)), convertToTimeT(row.get(7)))));
+      }
+      return mailList;
+    } catch (const std::exception &e) {
+      auto msg = fmt::v9::format("MailRepository: {}", e.what());
+      repoLogger->error(msg);
+      throw EntityException(msg);
+    }
+  }
+};
+
+std::shared_ptr<MailRepository> MailRepository::instance = nullptr;
+std::mutex MailRepository::createMutex{};
+} // namespace chat::dao
@@ -47,6 +47,17 @@ public:
   std::list<R> findAllInRoom(mysqlx::Session &session, uint64_t roomId) {
     return findAllBy(session, fmt::v9::format("room_id={}", roomId));
   }
+  std::list<R> findAllInRoomAfter(mysqlx::Session &session, uint64_t roomId,
+                                  uint64_t after, uint64_t limit) {
+    return findAllBy(
+        session,
+        fmt::v9::format("room_id={} AND participant_id>{}", roomId, after),
+        limit);
+  }
+
+  Version findVersionById(mysqlx::Session &session, uint64_t id) {
+    return findVersionBy(session, fmt::v9::format("participant_id={}", id));
+  }
 
   std::list<R> findAllByRoleInRoom(mysqlx::Session &session, std::string role,
                                    uint64_t roomId) {
@@ -169,14 +180,20 @@ private:
     }
   }
 
-  std::list<R> findAllBy(mysqlx::Session &session, std::string condition) {
+  std::list<R> findAllBy(mysqlx::Session &session, std::string condition,
+                         uint64_t limit = 0) {
     try {
       auto tableSelect =
           getTable(session, tableName)
               .select("room_id", "user_id", "role", "participant_id",
                       getUnixTimestampFormatter("created_at"),
                       getUnixTimestampFormatter("last_modified_at"));
-      auto result = tableSelect.where(condition).execute();
+      tableSelect.where(condition);
+      if (limit > 0) {
+        // keyset pagination : participant_id 순서로 limit개만 읽는다
+        tableSelect.orderBy("participant_id").limit(limit);
+      }
+      auto result = tableSelect.execute();
 
       auto rawList = result.fetchAll();
       auto filteredRawList = std::list<mysqlx::Row>{};
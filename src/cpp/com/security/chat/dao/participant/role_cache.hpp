@@ -0,0 +1,76 @@
+#pragma once
+
+#include "./entity.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+
+namespace chat::dao {
+
+class RoleCache {
+  /**
+   * room id -> role of one session's user in that room
+   * INVALID : not a participant
+   *
+   * Each entry remembers the epoch of its room when it was read. Changing a
+   * room's participants bumps that epoch, which makes the entries of every
+   * session stale at once. Rooms share epochs by id, so a change may also
+   * expire the entries of an unrelated room, never the opposite
+   *
+   * Epochs are local to this process, while session tokens are valid on
+   * every node. A change made on another node is therefore seen here only
+   * when the entry outlives `ttl` and the role is read again
+   */
+public:
+  using TYPE = Participant::TYPE;
+  using Clock = std::chrono::steady_clock;
+
+  static constexpr auto ttl = std::chrono::seconds(5);
+
+  RoleCache() = default;
+
+  static uint64_t epochOf(uint64_t roomId) {
+    return epochs[roomId % epochCount].load(std::memory_order_acquire);
+  }
+
+  static void invalidate(uint64_t roomId) {
+    epochs[roomId % epochCount].fetch_add(1, std::memory_order_acq_rel);
+  }
+
+  std::optional<TYPE> find(uint64_t roomId, uint64_t epoch) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto entry = roles.find(roomId);
+    if ((entry == roles.end()) || (entry->second.epoch != epoch) ||
+        (entry->second.expiredAt <= Clock::now())) {
+      return std::nullopt;
+    }
+    return entry->second.role;
+  }
+
+  void store(uint64_t roomId, TYPE role, uint64_t epoch) {
+    // epoch : read before the role, so a change in between is not hidden
+    std::lock_guard<std::mutex> lock(mutex);
+    roles.insert_or_assign(roomId, Entry{role, epoch, Clock::now() + ttl});
+  }
+
+private:
+  struct Entry {
+    TYPE role;
+    uint64_t epoch;
+    Clock::time_point expiredAt;
+  };
+
+  static constexpr uint64_t epochCount = 4096;
+  static std::array<std::atomic<uint64_t>, epochCount> epochs;
+
+  std::mutex mutex;
+  std::unordered_map<uint64_t, Entry> roles;
+};
+
+std::array<std::atomic<uint64_t>, RoleCache::epochCount> RoleCache::epochs{};
+} // namespace chat::dao
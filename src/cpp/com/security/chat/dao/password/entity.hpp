@@ -25,17 +25,21 @@ public:
   std::string getHashedPw() const { return this->hashedPw; }
   void setHashedPw(std::string hashedPw) { this->hashedPw = hashedPw; }
 
+  // KDF cost hashedPw was derived with (module::secure::hash)
+  uint32_t getCost() const { return this->cost; }
+  void setCost(uint32_t cost) { this->cost = cost; }
+
   Password(uint64_t userId, std::string salt, std::string hashedPw,
            uint64_t companyId = -1, uint64_t id = -1, time_t createdAt = 0,
-           time_t lastModifiedAt = 0)
+           time_t lastModifiedAt = 0, uint32_t cost = 0)
       : Base(id, createdAt, lastModifiedAt), userId(userId), salt(salt),
-        hashedPw(hashedPw), companyId(companyId) {}
+        hashedPw(hashedPw), companyId(companyId), cost(cost) {}
 
   operator std::string() const {
     return fmt::v9::format(
         "Password(id={}, userId={}, companyId={}, hashedPw={}, salt={}, "
-        "createdAt={}, lastModifiedAt={})",
-        id, userId, companyId, hashedPw, salt,
+        "cost={}, createdAt={}, lastModifiedAt={})",
+        id, userId, companyId, hashedPw, salt, cost,
         module::convertToLocalTimeString(createdAt),
         module::convertToLocalTimeString(lastModifiedAt));
   }
@@ -45,6 +49,7 @@ private:
   uint64_t companyId;
   std::string salt;
   std::string hashedPw;
+  uint32_t cost;
 
   Password() = delete;
 };
@@ -43,7 +43,7 @@ public:
           getTable(session, tableName)
               .select("user_id", "salt", "hashed_pw", "pw_id",
                       getUnixTimestampFormatter("created_at"),
-                      getUnixTimestampFormatter("last_modified_at"));
+                      getUnixTimestampFormatter("last_modified_at"), "cost");
       const auto condition = fmt::v9::format("user_id={}", userId);
       auto result = tableSelect.where(condition).execute();
 
@@ -58,7 +58,8 @@ public:
         auto entity = R(new Password(
             std::uint64_t(row.get(0)), std::string(row.get(1)),
             std::string(row.get(2)), -1, uint64_t(row.get(3)),
-            convertToTimeT(row.get(4)), convertToTimeT(row.get(5))));
+            convertToTimeT(row.get(4)), convertToTimeT(row.get(5)),
+            uint32_t(uint64_t(row.get(6)))));
         return entity;
       } else {
         return nullptr;
@@ -76,7 +77,7 @@ public:
           getTable(session, tableName)
               .select("salt", "hashed_pw", "company_id", "pw_id",
                       getUnixTimestampFormatter("created_at"),
-                      getUnixTimestampFormatter("last_modified_at"));
+                      getUnixTimestampFormatter("last_modified_at"), "cost");
       const auto condition = fmt::v9::format("company_id={}", companyId);
       auto result = tableSelect.where(condition).execute();
 
@@ -91,7 +92,8 @@ public:
         auto entity = R(new Password(
             -1, std::string(row.get(0)), std::string(row.get(1)),
             uint64_t(row.get(2)), uint64_t(row.get(3)),
-            convertToTimeT(row.get(4)), convertToTimeT(row.get(5))));
+            convertToTimeT(row.get(4)), convertToTimeT(row.get(5)),
+            uint32_t(uint64_t(row.get(6)))));
         return entity;
       } else {
         return nullptr;
@@ -112,11 +114,12 @@ public:
   R saveWithUserId(mysqlx::Session &session, E entity) {
     std::lock_guard<std::mutex> lock(sessionMutex);
     try {
-      auto tableInsert =
-          getTable(session, tableName).insert("user_id", "salt", "hashed_pw");
+      auto tableInsert = getTable(session, tableName)
+                             .insert("user_id", "salt", "hashed_pw", "cost");
       const auto password = std::dynamic_pointer_cast<Password>(entity);
       const auto row = mysqlx::Row(password->getUserId(), password->getSalt(),
-                                   password->getHashedPw());
+                                   password->getHashedPw(),
+                                   password->getCost());
       const auto result = tableInsert.values(row).execute();
       return findByUserId(session, password->getUserId());
     } catch (const std::exception &e) {
@@ -129,12 +132,13 @@ public:
   R saveWithCompanyId(mysqlx::Session &session, E entity) {
     std::lock_guard<std::mutex> lock(sessionMutex);
     try {
-      auto tableInsert = getTable(session, tableName)
-                             .insert("company_id", "salt", "hashed_pw");
+      auto tableInsert =
+          getTable(session, tableName)
+              .insert("company_id", "salt", "hashed_pw", "cost");
       const auto password = std::dynamic_pointer_cast<Password>(entity);
       const auto row =
           mysqlx::Row(password->getCompanyId(), password->getSalt(),
-                      password->getHashedPw());
+                      password->getHashedPw(), password->getCost());
       const auto result = tableInsert.values(row).execute();
       return findByCompanyId(session, password->getCompanyId());
     } catch (const std::exception &e) {
@@ -160,6 +164,7 @@ public:
       const auto result =
           tableUpdate.set("salt", password->getSalt())
               .set("hashed_pw", password->getHashedPw())
+              .set("cost", password->getCost())
               .set("last_modified_at",
                    module::convertToLocalTimeString(module::getCurrentTime()))
               .where(condition)
@@ -182,6 +187,7 @@ public:
       const auto result =
           tableUpdate.set("salt", password->getSalt())
               .set("hashed_pw", password->getHashedPw())
+              .set("cost", password->getCost())
               .set("last_modified_at",
                    module::convertToLocalTimeString(module::getCurrentTime()))
               .where(condition)
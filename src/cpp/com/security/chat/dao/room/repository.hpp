@@ -50,6 +50,14 @@ public:
   std::list<R> findAll(mysqlx::Session &session) {
     return findAllBy(session, fmt::v9::format("true"));
   }
+  std::list<R> findAllAfter(mysqlx::Session &session, uint64_t after,
+                            uint64_t limit) {
+    return findAllBy(session, fmt::v9::format("room_id>{}", after), limit);
+  }
+
+  Version findVersionById(mysqlx::Session &session, uint64_t id) {
+    return findVersionBy(session, fmt::v9::format("room_id={}", id));
+  }
 
   R save(mysqlx::Session &session, E entity) override {
     std::lock_guard<std::mutex> lock(sessionMutex);
@@ -155,14 +163,20 @@ private:
     }
   }
 
-  std::list<R> findAllBy(mysqlx::Session &session, std::string condition) {
+  std::list<R> findAllBy(mysqlx::Session &session, std::string condition,
+                         uint64_t limit = 0) {
     try {
       auto tableSelect =
           getTable(session, tableName)
               .select("name", getUnixTimestampFormatter("deleted_at"),
                       "room_id", getUnixTimestampFormatter("created_at"),
                       getUnixTimestampFormatter("last_modified_at"));
-      auto result = tableSelect.where(condition).execute();
+      tableSelect.where(condition);
+      if (limit > 0) {
+        // keyset pagination : room_id 순서로 limit개만 읽는다
+        tableSelect.orderBy("room_id").limit(limit);
+      }
+      auto result = tableSelect.execute();
 
       auto rawList = result.fetchAll();
       auto filteredRawList = std::list<mysqlx::Row>{};
@@ -1,40 +1,81 @@
 #pragma once
 
 #include "../base/entity.hpp"
+#include "../company/entity.hpp"
 
 #include "../../module/common.hpp"
+#include "../../module/token.hpp"
 
 #include <chrono>
+#include <functional>
+#include <memory>
 #include <string>
 
 namespace chat::dao {
 
 class ServerSession : public Base {
+  /**
+   * One cached session : principal + expiry, nothing else
+   * The token is not stored; it is a pure function of the session
+   * (module::TokenSigner) and is signed again when a reply needs it
+   */
 public:
   using V = std::shared_ptr<Base>;
+  using TYPE = module::TokenSigner::TYPE;
+
+  struct Principal {
+    TYPE type;
+    uint64_t id;
+
+    bool operator==(const Principal &other) const {
+      return (type == other.type) && (id == other.id);
+    }
+
+    static Principal of(const V &value) {
+      return {std::dynamic_pointer_cast<Company>(value) != nullptr
+                  ? TYPE::COMPANY
+                  : TYPE::USER,
+              value->getId()};
+    }
+  };
+
+  struct PrincipalHash {
+    size_t operator()(const Principal &principal) const {
+      return std::hash<uint64_t>{}(principal.id) ^
+             static_cast<size_t>(principal.type);
+    }
+  };
+
   V getValue() const { return this->value; }
   void setValue(V value) { this->value = value; }
 
-  time_t getExpiredAt() const {
-    return std::mktime(const_cast<std::tm *>(&this->expiredAt));
-  }
-  void setExpiredAt(std::tm expiredAt) { this->expiredAt = expiredAt; }
+  // known even before the value is resolved
+  Principal getPrincipal() const { return this->principal; }
+
+  time_t getExpiredAt() const { return this->expiredAt; }
+  void setExpiredAt(time_t expiredAt) { this->expiredAt = expiredAt; }
 
-  std::string getToken() const { return this->token; }
-  void setToken(std::string token) { this->token = token; }
+  std::string getToken() const {
+    return module::TokenSigner::getInstance()->sign(
+        {principal.type, principal.id, this->id, this->expiredAt});
+  }
 
   void setId(uint64_t id) { this->id = id; }
 
-  ServerSession(V value, std::string token, std::tm expiredAt, uint64_t id = -1,
+  ServerSession(V value, time_t expiredAt, uint64_t id = -1,
                 time_t createdAt = 0, time_t lastModifiedAt = 0)
-      : Base(id, createdAt, lastModifiedAt), value(value), token(token),
-        expiredAt(expiredAt) {}
+      : Base(id, createdAt, lastModifiedAt), value(value),
+        principal(Principal::of(value)), expiredAt(expiredAt) {}
+
+  // restored : the principal is only known by its key
+  ServerSession(Principal principal, time_t expiredAt, uint64_t id)
+      : Base(id), value(nullptr), principal(principal), expiredAt(expiredAt) {}
 
 private:
   V value;
-  std::tm expiredAt;
-  std::string token;
+  Principal principal;
+  time_t expiredAt;
 
   ServerSession() = delete;
 };
-} // namespace chat::dao
\ No newline at end of file
+} // namespace chat::dao
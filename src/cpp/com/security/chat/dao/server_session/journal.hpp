@@ -0,0 +1,204 @@
+#pragma once
+
+#include "../../module/exception.hpp"
+using namespace chat::module::exception;
+
+#include <fmt/core.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace chat::dao {
+
+class SessionJournal {
+  /**
+   * Keeps the session table across restarts
+   *  - <path>.snapshot : the whole table at one moment, read through mmap
+   *  - <path>.journal : every save / revoke / drop since that snapshot
+   * Both are a header followed by fixed-size records, so loading is one
+   * pass over mapped memory. A record cut short by a crash is ignored, and
+   * truncated away before the next append.
+   * Records of one id may be appended out of order; the one with the
+   * highest seq is its latest state.
+   * Appends are not fsync'ed; a crash may lose the last few, which only
+   * means those sessions log in again
+   */
+public:
+  enum class OP : uint8_t { SAVE = 1, REVOKE = 2, DROP = 3 };
+
+  struct Record {
+    uint64_t sessionId;
+    int64_t expiredAt;
+    uint64_t principalId;
+    OP op;
+    char principalType; // module::TokenSigner::TYPE
+    uint8_t reserved[6];
+    uint64_t seq;
+  };
+
+  SessionJournal(std::string path)
+      : snapshotPath(path + ".snapshot"), journalPath(path + ".journal"),
+        journalFd(-1), snapshotRecords(0), journalRecords(0) {}
+
+  ~SessionJournal() {
+    if (journalFd >= 0) {
+      ::close(journalFd);
+    }
+  }
+
+  template <typename F> void load(F &&apply) {
+    /**
+     * apply(record) for the snapshot, then for the journal in order
+     * The journal is opened for appending afterwards
+     */
+    std::lock_guard<std::mutex> lock(journalMutex);
+    snapshotRecords = read(snapshotPath, apply);
+    journalRecords = read(journalPath, apply);
+
+    journalFd = ::open(journalPath.c_str(), O_WRONLY | O_CREAT | O_APPEND,
+                       S_IRUSR | S_IWUSR);
+    if (journalFd < 0) {
+      throw EntityException(fmt::v9::format(
+          "SessionJournal : {} : {}", journalPath, std::strerror(errno)));
+    }
+    if (journalRecords == 0) {
+      // a new or empty journal : start it with its header
+      ::ftruncate(journalFd, 0);
+      writeAll(journalFd, &header, sizeof(header));
+    } else {
+      // drop a record cut short by a crash, so appends stay aligned
+      ::ftruncate(journalFd, sizeof(Header) + journalRecords * sizeof(Record));
+    }
+  }
+
+  void append(const Record &record) {
+    std::lock_guard<std::mutex> lock(journalMutex);
+    if (journalFd < 0) {
+      return;
+    }
+    writeAll(journalFd, &record, sizeof(record));
+    ++journalRecords;
+  }
+
+  template <typename F> bool compact(F &&collect, bool force = false) {
+    /**
+     * Once the journal outgrows the snapshot, writes collect() as the new
+     * snapshot and empties the journal.
+     * Appends wait meanwhile, so none falls between the two
+     */
+    std::lock_guard<std::mutex> lock(journalMutex);
+    if ((journalFd < 0) ||
+        ((force == false) &&
+         (journalRecords < std::max(compactFloor, snapshotRecords)))) {
+      return false;
+    }
+
+    std::vector<Record> records = collect();
+
+    auto tmpPath = snapshotPath + ".tmp";
+    int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC,
+                    S_IRUSR | S_IWUSR);
+    if (fd < 0) {
+      throw EntityException(fmt::v9::format("SessionJournal : {} : {}",
+                                            tmpPath, std::strerror(errno)));
+    }
+    writeAll(fd, &header, sizeof(header));
+    writeAll(fd, records.data(), records.size() * sizeof(Record));
+    ::fsync(fd);
+    ::close(fd);
+    if (std::rename(tmpPath.c_str(), snapshotPath.c_str()) != 0) {
+      throw EntityException(fmt::v9::format(
+          "SessionJournal : {} : {}", snapshotPath, std::strerror(errno)));
+    }
+
+    ::ftruncate(journalFd, 0);
+    writeAll(journalFd, &header, sizeof(header));
+    snapshotRecords = records.size();
+    journalRecords = 0;
+    return true;
+  }
+
+private:
+  struct Header {
+    char magic[4];
+    uint32_t recordSize;
+  };
+
+  static constexpr Header header{{'C', 'S', 'J', '2'}, sizeof(Record)};
+  static constexpr uint64_t compactFloor = 4096;
+
+  template <typename F>
+  static uint64_t read(const std::string &path, F &&apply) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      // nothing persisted yet
+      return 0;
+    }
+    struct stat st {};
+    if ((::fstat(fd, &st) != 0) || (uint64_t(st.st_size) < sizeof(Header))) {
+      ::close(fd);
+      return 0;
+    }
+
+    auto size = uint64_t(st.st_size);
+    void *mapped = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+      throw EntityException(fmt::v9::format("SessionJournal : {} : {}", path,
+                                            std::strerror(errno)));
+    }
+
+    uint64_t count = 0;
+    auto begin = static_cast<const unsigned char *>(mapped);
+    if (std::memcmp(begin, &header, sizeof(Header)) == 0) {
+      count = (size - sizeof(Header)) / sizeof(Record);
+      for (uint64_t i = 0; i < count; ++i) {
+        Record record;
+        std::memcpy(&record, begin + sizeof(Header) + i * sizeof(Record),
+                    sizeof(Record));
+        apply(record);
+      }
+    }
+    ::munmap(mapped, size);
+    return count;
+  }
+
+  static void writeAll(int fd, const void *data, size_t size) {
+    auto bytes = static_cast<const char *>(data);
+    while (size > 0) {
+      auto written = ::write(fd, bytes, size);
+      if (written < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        throw EntityException(fmt::v9::format("SessionJournal : write : {}",
+                                              std::strerror(errno)));
+      }
+      bytes += written;
+      size -= written;
+    }
+  }
+
+  std::string snapshotPath;
+  std::string journalPath;
+
+  std::mutex journalMutex;
+  int journalFd;
+  uint64_t snapshotRecords;
+  uint64_t journalRecords;
+
+  SessionJournal() = delete;
+};
+} // namespace chat::dao
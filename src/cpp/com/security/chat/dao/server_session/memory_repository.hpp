@@ -3,6 +3,7 @@
 #include "../base/entity.hpp"
 #include "../base/repository.hpp"
 #include "./entity.hpp"
+#include "./journal.hpp"
 
 #include "../../module/all.hpp"
 using namespace chat::module::exception;
@@ -11,16 +12,41 @@ using namespace chat::module::exception;
 
 #include <mysqlx/xdevapi.h>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <chrono>
 #include <exception>
+#include <functional>
 #include <memory>
 #include <mutex>
+#include <shared_mutex>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 namespace chat::dao {
 
 class ServerSessionRepository : public BaseRepository {
+  /**
+   * Sessions are spread over independently locked stripes by id.
+   * Readers of a stripe share its lock and never wait for each other; a
+   * writer only excludes the readers and writers of its own stripe
+   *
+   * A session token is self-contained (module::TokenSigner), so this table
+   * is a cache of the principals behind the tokens seen by this process,
+   * plus the list of sessions revoked before they expire
+   *
+   * With open(), every change is also appended to a SessionJournal, so a
+   * restarted process gets its sessions and revocations back. A session
+   * restored that way has only the key of its principal (value == nullptr)
+   * until its token is presented again
+   *
+   * principal -> session ids is indexed alongside, under the stripe lock of
+   * the session, so the sessions of one principal are found without a scan
+   */
 public:
   using K = uint64_t;
   using V = std::shared_ptr<ServerSession>;
@@ -34,13 +60,15 @@ public:
   }
 
   ServerSessionRepository(L repoLogger)
-      : BaseRepository(repoLogger, "server_session"), db{} {};
+      : BaseRepository(repoLogger, "server_session"){};
 
   R findById(mysqlx::Session &session, uint64_t id) override {
     try {
-      auto serverSession = this->db.find(id);
+      auto &stripe = stripeOf(id);
+      std::shared_lock<std::shared_mutex> lock(stripe.mutex);
+      auto serverSession = stripe.sessions.find(id);
 
-      if (serverSession != this->db.end()) {
+      if (serverSession != stripe.sessions.end()) {
         auto entity = serverSession->second;
         return entity;
       } else {
@@ -53,23 +81,232 @@ public:
     }
   }
 
-  R save(mysqlx::Session &session, E entity) override {
-    std::lock_guard<std::mutex> lock(sessionMutex);
+  V find(K id) {
+    // the same lookup as findById, for callers holding no mysqlx::Session
+    auto &stripe = stripeOf(id);
+    std::shared_lock<std::shared_mutex> lock(stripe.mutex);
+    auto serverSession = stripe.sessions.find(id);
+    if (serverSession == stripe.sessions.end()) {
+      return nullptr;
+    }
+    return serverSession->second;
+  }
+
+  std::vector<std::pair<K, time_t>> open(std::string path) {
+    /**
+     * Restores the table from path.snapshot + path.journal, then journals
+     * every change from here on. Call once, before serving.
+     * Entries that expired while the process was down are dropped
+     * return : (id, expiredAt) of the restored sessions and revocations,
+     *          for the reaper
+     */
     try {
-      auto serverSession = std::dynamic_pointer_cast<ServerSession>(entity);
-      auto key = module::secure::generateRandomNumber();
-      while (findById(session, key) != nullptr) {
-        key = module::secure::generateRandomNumber();
+      auto opened = std::make_unique<SessionJournal>(path);
+      auto latest = std::unordered_map<K, SessionJournal::Record>{};
+      uint64_t lastSeq = 0;
+      opened->load([&latest, &lastSeq](const SessionJournal::Record &record) {
+        // the highest seq wins; on a tie, the later record (journal over
+        // snapshot) does
+        auto &&[it, inserted] = latest.try_emplace(record.sessionId, record);
+        if ((inserted == false) && (it->second.seq <= record.seq)) {
+          it->second = record;
+        }
+        lastSeq = std::max(lastSeq, record.seq);
+      });
+      seq.store(lastSeq + 1, std::memory_order_relaxed);
+
+      auto now = module::getCurrentTime();
+      auto restored = std::vector<std::pair<K, time_t>>{};
+      for (const auto &[id, record] : latest) {
+        time_t expiredAt = record.expiredAt;
+        if ((record.op == SessionJournal::OP::DROP) || (expiredAt <= now)) {
+          continue;
+        }
+        auto &stripe = stripeOf(id);
+        std::unique_lock<std::shared_mutex> lock(stripe.mutex);
+        if (record.op == SessionJournal::OP::REVOKE) {
+          stripe.revoked.insert_or_assign(id, expiredAt);
+          restored.emplace_back(id, expiredAt);
+        } else {
+          auto serverSession = std::make_shared<ServerSession>(
+              ServerSession::Principal{
+                  static_cast<ServerSession::TYPE>(record.principalType),
+                  record.principalId},
+              expiredAt, id);
+          if (stripe.sessions.try_emplace(id, serverSession).second) {
+            index(serverSession);
+            restored.emplace_back(id, expiredAt);
+          }
+        }
       }
-      // The key is The id of entity
-      serverSession->setId(key);
-      auto &&[it, inserted] = this->db.insert({key, serverSession});
 
-      if (inserted) {
-        return it->second;
-      } else {
+      journal = std::move(opened);
+      // start from a snapshot without the expired entries
+      compact(true);
+      repoLogger->info(fmt::v9::format(
+          "ServerSessionRepository : restored {} sessions & revocations "
+          "from {}",
+          restored.size(), path));
+      return restored;
+    } catch (const std::exception &e) {
+      auto msg = fmt::v9::format("ServerSessionRepository : {}", e.what());
+      repoLogger->error(msg);
+      throw EntityException(msg);
+    }
+  }
+
+  bool compact(bool force = false) {
+    // Rewrites the snapshot once the journal has outgrown it
+    if (journal == nullptr) {
+      return false;
+    }
+    return journal->compact(
+        [this]() {
+          auto records = std::vector<SessionJournal::Record>{};
+          for (auto &stripe : stripes) {
+            std::shared_lock<std::shared_mutex> lock(stripe.mutex);
+            // newer than every change applied to this stripe so far
+            auto snapshotSeq = seq.load(std::memory_order_relaxed);
+            for (const auto &[id, serverSession] : stripe.sessions) {
+              records.push_back(recordOf(SessionJournal::OP::SAVE,
+                                         serverSession, snapshotSeq));
+            }
+            for (const auto &[id, expiredAt] : stripe.revoked) {
+              records.push_back(revokeRecordOf(id, expiredAt, snapshotSeq));
+            }
+          }
+          return records;
+        },
+        force);
+  }
+
+  std::pair<V, bool> emplace(V serverSession) {
+    /**
+     * Caches a session verified from its token; the first one wins, unless
+     * it was restored without its principal
+     * return : (the cached session, nullptr if it was revoked meanwhile,
+     *           true if it was not in the table before : neither cached nor
+     *           restored by open())
+     */
+    auto &stripe = stripeOf(serverSession->getId());
+    std::unique_lock<std::shared_mutex> lock(stripe.mutex);
+    if (stripe.revoked.find(serverSession->getId()) != stripe.revoked.end()) {
+      return {nullptr, false};
+    }
+    auto &&[it, inserted] =
+        stripe.sessions.try_emplace(serverSession->getId(), serverSession);
+    if (inserted == false) {
+      if (it->second->getValue() != nullptr) {
+        return {it->second, false};
+      }
+      // restored by open() : resolved now, indexed already
+      it->second = serverSession;
+    } else {
+      index(serverSession);
+    }
+    auto changed = nextSeq();
+    lock.unlock();
+    append(recordOf(SessionJournal::OP::SAVE, serverSession, changed));
+    return {serverSession, inserted};
+  }
+
+  V renew(V serverSession) {
+    /**
+     * Replaces a cached session with its renewed copy
+     * return : the renewed session, nullptr if revoked or gone meanwhile
+     */
+    auto changed = uint64_t{0};
+    {
+      auto &stripe = stripeOf(serverSession->getId());
+      std::unique_lock<std::shared_mutex> lock(stripe.mutex);
+      auto cached = stripe.sessions.find(serverSession->getId());
+      if (cached == stripe.sessions.end()) {
         return nullptr;
       }
+      cached->second = serverSession;
+      changed = nextSeq();
+    }
+    append(recordOf(SessionJournal::OP::SAVE, serverSession, changed));
+    return serverSession;
+  }
+
+  void revoke(K id, time_t expiredAt) {
+    // Its token stays valid until expiredAt, so remember it until then
+    auto changed = uint64_t{0};
+    {
+      auto &stripe = stripeOf(id);
+      std::unique_lock<std::shared_mutex> lock(stripe.mutex);
+      auto serverSession = stripe.sessions.find(id);
+      if (serverSession != stripe.sessions.end()) {
+        unindex(serverSession->second);
+        stripe.sessions.erase(serverSession);
+      }
+      stripe.revoked.insert_or_assign(id, expiredAt);
+      changed = nextSeq();
+    }
+    append(revokeRecordOf(id, expiredAt, changed));
+  }
+
+  std::vector<V> findAllOf(ServerSession::Principal principal) {
+    // live sessions of one principal, in time proportional to their number
+    auto ids = std::vector<K>{};
+    {
+      auto &stripe = indexStripeOf(principal);
+      std::lock_guard<std::mutex> lock(stripe.mutex);
+      auto sessionIds = stripe.sessions.find(principal);
+      if (sessionIds != stripe.sessions.end()) {
+        ids.assign(sessionIds->second.begin(), sessionIds->second.end());
+      }
+    }
+
+    auto serverSessions = std::vector<V>{};
+    serverSessions.reserve(ids.size());
+    for (auto id : ids) {
+      auto serverSession = find(id);
+      if (serverSession != nullptr) {
+        serverSessions.emplace_back(serverSession);
+      }
+    }
+    return serverSessions;
+  }
+
+  uint64_t revokeAllOf(ServerSession::Principal principal) {
+    /**
+     * logout everywhere, or after the password has changed
+     * return : the number of sessions revoked
+     */
+    auto serverSessions = findAllOf(principal);
+    for (const auto &serverSession : serverSessions) {
+      revoke(serverSession->getId(), serverSession->getExpiredAt());
+    }
+    return serverSessions.size();
+  }
+
+  bool isRevoked(K id) {
+    auto &stripe = stripeOf(id);
+    std::shared_lock<std::shared_mutex> lock(stripe.mutex);
+    return stripe.revoked.find(id) != stripe.revoked.end();
+  }
+
+  R save(mysqlx::Session &session, E entity) override {
+    try {
+      auto serverSession = std::dynamic_pointer_cast<ServerSession>(entity);
+      while (true) {
+        // The key is The id of entity, retry on collision
+        auto key = module::secure::generateRandomNumber();
+        auto &stripe = stripeOf(key);
+        std::unique_lock<std::shared_mutex> lock(stripe.mutex);
+        auto &&[it, inserted] = stripe.sessions.try_emplace(key, nullptr);
+        if (inserted) {
+          serverSession->setId(key);
+          it->second = serverSession;
+          index(serverSession);
+          auto changed = nextSeq();
+          lock.unlock();
+          append(recordOf(SessionJournal::OP::SAVE, serverSession, changed));
+          return serverSession;
+        }
+      }
     } catch (const std::exception &e) {
       auto msg = fmt::v9::format("ServerSessionRepository : {}", e.what());
       repoLogger->error(msg);
@@ -78,13 +315,22 @@ public:
   }
 
   R update(mysqlx::Session &session, E entity) override {
-    std::lock_guard<std::mutex> lock(sessionMutex);
     try {
       auto serverSession = std::dynamic_pointer_cast<ServerSession>(entity);
-      auto &&[it, updated] =
-          this->db.insert_or_assign(serverSession->getId(), serverSession);
+      auto &stripe = stripeOf(serverSession->getId());
+      std::unique_lock<std::shared_mutex> lock(stripe.mutex);
+      auto cached = stripe.sessions.find(serverSession->getId());
+      if (cached != stripe.sessions.end()) {
+        unindex(cached->second);
+      }
+      auto id = serverSession->getId();
+      auto updated = stripe.sessions.insert_or_assign(id, serverSession).second;
+      index(serverSession);
+      auto changed = nextSeq();
+      lock.unlock();
+      append(recordOf(SessionJournal::OP::SAVE, serverSession, changed));
       if (updated) {
-        return it->second;
+        return serverSession;
       } else {
         return nullptr;
       }
@@ -96,11 +342,21 @@ public:
   }
 
   bool remove(mysqlx::Session &session, E entity) override {
-    std::lock_guard<std::mutex> lock(sessionMutex);
     try {
       auto serverSession = std::dynamic_pointer_cast<ServerSession>(entity);
-      auto erased = this->db.erase(serverSession->getId());
-      if (erased != 0) {
+      auto &stripe = stripeOf(serverSession->getId());
+      std::unique_lock<std::shared_mutex> lock(stripe.mutex);
+      auto cached = stripe.sessions.find(serverSession->getId());
+      auto erased = (cached != stripe.sessions.end());
+      auto changed = uint64_t{0};
+      if (erased) {
+        unindex(cached->second);
+        stripe.sessions.erase(cached);
+        changed = nextSeq();
+      }
+      lock.unlock();
+      if (erased) {
+        append(recordOf(SessionJournal::OP::DROP, serverSession, changed));
         return true;
       } else {
         return false;
@@ -112,12 +368,145 @@ public:
     }
   }
 
+  time_t removeIfExpired(K id, time_t now) {
+    /**
+     * For the background reaper, which holds no mysqlx::Session
+     * Checks and removes under one stripe lock, so a session refreshed in
+     * between is never dropped. A revocation whose token has expired is
+     * dropped as well. Neither is journaled: expired entries are skipped
+     * when the journal is loaded.
+     * A session refreshed and then revoked is remembered until its new
+     * expiry, which lies past the entry that fired : that one is returned,
+     * so the id is scheduled again
+     * return : expiredAt of the session (<= now : removed), expiredAt of
+     *          its revocation (> now : still kept), 0 if neither remains
+     */
+    auto &stripe = stripeOf(id);
+    std::unique_lock<std::shared_mutex> lock(stripe.mutex);
+    auto revoked = stripe.revoked.find(id);
+    auto revokedUntil = time_t{0};
+    if (revoked != stripe.revoked.end()) {
+      if (revoked->second <= now) {
+        // the token has expired as well
+        stripe.revoked.erase(revoked);
+      } else {
+        revokedUntil = revoked->second;
+      }
+    }
+    auto serverSession = stripe.sessions.find(id);
+    if (serverSession == stripe.sessions.end()) {
+      return revokedUntil;
+    }
+    auto expiredAt = serverSession->second->getExpiredAt();
+    if (expiredAt <= now) {
+      unindex(serverSession->second);
+      stripe.sessions.erase(serverSession);
+    }
+    return expiredAt;
+  }
+
+  uint64_t size() {
+    uint64_t count = 0;
+    for (auto &stripe : stripes) {
+      std::shared_lock<std::shared_mutex> lock(stripe.mutex);
+      count += stripe.sessions.size();
+    }
+    return count;
+  }
+
 private:
   static std::shared_ptr<ServerSessionRepository> instance;
   static std::mutex createMutex;
   ServerSessionRepository() = delete;
 
-  std::unordered_map<K, V> db;
+  struct Stripe {
+    std::shared_mutex mutex;
+    std::unordered_map<K, V> sessions;
+    // session id -> expiredAt of its token
+    std::unordered_map<K, time_t> revoked;
+  };
+
+  struct IndexStripe {
+    std::mutex mutex;
+    std::unordered_map<ServerSession::Principal, std::unordered_set<K>,
+                       ServerSession::PrincipalHash>
+        sessions;
+  };
+
+  Stripe &stripeOf(K key) {
+    return stripes[std::hash<K>{}(key) % stripeCount];
+  }
+
+  IndexStripe &indexStripeOf(const ServerSession::Principal &principal) {
+    return indexStripes[ServerSession::PrincipalHash{}(principal) %
+                        stripeCount];
+  }
+
+  void index(const V &serverSession) {
+    // under the stripe lock of the session : session lock -> index lock
+    auto &stripe = indexStripeOf(serverSession->getPrincipal());
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    stripe.sessions[serverSession->getPrincipal()].insert(
+        serverSession->getId());
+  }
+
+  void unindex(const V &serverSession) {
+    auto &stripe = indexStripeOf(serverSession->getPrincipal());
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    auto sessionIds = stripe.sessions.find(serverSession->getPrincipal());
+    if (sessionIds == stripe.sessions.end()) {
+      return;
+    }
+    sessionIds->second.erase(serverSession->getId());
+    if (sessionIds->second.empty()) {
+      stripe.sessions.erase(sessionIds);
+    }
+  }
+
+  static SessionJournal::Record recordOf(SessionJournal::OP op,
+                                         const V &serverSession,
+                                         uint64_t changed) {
+    auto principal = serverSession->getPrincipal();
+    return {serverSession->getId(),
+            serverSession->getExpiredAt(),
+            principal.id,
+            op,
+            static_cast<char>(principal.type),
+            {},
+            changed};
+  }
+
+  static SessionJournal::Record revokeRecordOf(K id, time_t expiredAt,
+                                               uint64_t changed) {
+    return {id, expiredAt, 0, SessionJournal::OP::REVOKE, 0, {}, changed};
+  }
+
+  uint64_t nextSeq() {
+    // under the stripe lock of the change, so the changes of one id are
+    // numbered in the order they were applied
+    return seq.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void append(const SessionJournal::Record &record) {
+    /**
+     * Appended after the stripe lock is released, since compaction takes
+     * the journal lock before the stripe locks. Two changes of one id may
+     * thus land out of order, or after a compaction already captured them;
+     * open() keeps the record with the highest seq, so either is harmless
+     */
+    if (journal != nullptr) {
+      journal->append(record);
+    }
+  }
+
+  static constexpr uint64_t stripeCount = 64;
+
+  std::array<Stripe, stripeCount> stripes;
+  std::array<IndexStripe, stripeCount> indexStripes;
+  // set by open() before serving, read-only afterwards
+  std::unique_ptr<SessionJournal> journal;
+  // order of the changes, continued from the journal by open()
+  std::atomic<uint64_t> seq{1};
 };
 
 std::shared_ptr<ServerSessionRepository> ServerSessionRepository::instance =
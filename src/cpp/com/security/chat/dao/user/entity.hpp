@@ -1,12 +1,14 @@
 #pragma once
 
 #include "../base/entity.hpp"
+#include "../participant/role_cache.hpp"
 
 #include "../../module/common.hpp"
 
 #include <fmt/core.h>
 
 #include <chrono>
+#include <memory>
 #include <string>
 
 namespace chat::dao {
@@ -24,6 +26,10 @@ public:
   std::string getEmail() const { return this->email; }
   void setEmail(std::string email) { this->email = email; }
 
+  // only the principal of a ServerSession has one
+  std::shared_ptr<RoleCache> getRoles() const { return this->roles; }
+  void setRoles(std::shared_ptr<RoleCache> roles) { this->roles = roles; }
+
   User(uint64_t companyId, std::string name, std::string role,
        std::string email, uint64_t id = -1, time_t createdAt = 0,
        time_t lastModifiedAt = 0)
@@ -45,6 +51,7 @@ private:
   std::string name;
   std::string role; // ex) Boss, Developer ...
   std::string email;
+  std::shared_ptr<RoleCache> roles;
 
   User() = delete;
 };
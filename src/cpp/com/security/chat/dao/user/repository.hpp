@@ -63,6 +63,18 @@ public:
                                   uint64_t companyId) {
     return findAllBy(session, fmt::v9::format("company_id={}", companyId));
   }
+  std::list<R> findAllByCompanyIdAfter(mysqlx::Session &session,
+                                       uint64_t companyId, uint64_t after,
+                                       uint64_t limit) {
+    return findAllBy(
+        session,
+        fmt::v9::format("company_id={} AND user_id>{}", companyId, after),
+        limit);
+  }
+
+  Version findVersionById(mysqlx::Session &session, uint64_t id) {
+    return findVersionBy(session, fmt::v9::format("user_id={}", id));
+  }
 
   std::list<R> findAllByRole(mysqlx::Session &session, std::string role) {
     if (module::secure::verifyUserInput(role)) {
@@ -218,14 +230,20 @@ private:
     }
   }
 
-  std::list<R> findAllBy(mysqlx::Session &session, std::string condition) {
+  std::list<R> findAllBy(mysqlx::Session &session, std::string condition,
+                         uint64_t limit = 0) {
     try {
       auto tableSelect =
           getTable(session, tableName)
               .select("company_id", "name", "role", "email", "user_id",
                       getUnixTimestampFormatter("created_at"),
                       getUnixTimestampFormatter("last_modified_at"));
-      auto result = tableSelect.where(condition).execute();
+      tableSelect.where(condition);
+      if (limit > 0) {
+        // keyset pagination : user_id 순서로 limit개만 읽는다
+        tableSelect.orderBy("user_id").limit(limit);
+      }
+      auto result = tableSelect.execute();
 
       auto rawList = result.fetchAll();
       auto filteredRawList = std::list<mysqlx::Row>{};
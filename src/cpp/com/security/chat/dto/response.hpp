@@ -8,6 +8,7 @@
 #include <initializer_list>
 #include <iterator>
 #include <list>
+#include <map>
 #include <string>
 #include <vector>
 
@@ -21,7 +22,9 @@ enum CODE {
   NOT_UPDATED = 406,
   NOT_SAVED = 407,
   NOT_REMOVED = 408,
-  UNEXPECTED = 500
+  TOO_MANY_REQUESTS = 429,
+  UNEXPECTED = 500,
+  SERVICE_UNAVAILABLE = 503
 };
 
 using Serializable =
@@ -138,12 +141,18 @@ public:
 
 class ServerSessionData : public Data {
 public:
-  ServerSessionData(dao::ServerSession &serverSession) {
+  // withToken : only to the client the session was just issued to
+  ServerSessionData(dao::ServerSession &serverSession, bool withToken = true) {
     Serializable serverSessionData;
     serverSessionData.emplace_back(
         "id", web::json::value::string(std::to_string(serverSession.getId())));
+    if (withToken) {
+      serverSessionData.emplace_back(
+          "token", web::json::value::string(serverSession.getToken()));
+    }
     serverSessionData.emplace_back(
-        "token", web::json::value::string(serverSession.getToken()));
+        "expiredAt", web::json::value::string(module::convertToLocalTimeString(
+                         serverSession.getExpiredAt())));
     data.emplace_back("session", web::json::value::object(serverSessionData));
   }
 };
@@ -181,6 +190,37 @@ public:
   }
 };
 
+class PageData : public ArrayData {
+  // next : 다음 page를 요청할 때의 after, "0"이면 마지막 page
+public:
+  PageData(std::list<Data> array, uint64_t next) : ArrayData(array) {
+    data.emplace_back("next", web::json::value::string(std::to_string(next)));
+  }
+};
+
+class BatchData : public Data {
+public:
+  BatchData(std::vector<Response> responses) {
+    std::vector<web::json::value> batchData;
+    std::transform(
+        responses.begin(), responses.end(), std::back_inserter(batchData),
+        [](const Response &response) { return response.serialize(); });
+    data.emplace_back("batch", web::json::value::array(batchData));
+  }
+};
+
+class MetricsData : public Data {
+public:
+  MetricsData(const std::map<std::string, int64_t> &metrics) {
+    Serializable metricsData;
+    for (const auto &[name, value] : metrics) {
+      metricsData.emplace_back(name,
+                               web::json::value::string(std::to_string(value)));
+    }
+    data.emplace_back("metrics", web::json::value::object(metricsData));
+  }
+};
+
 class MsgData : public Data {
 public:
   MsgData(std::string msg) {
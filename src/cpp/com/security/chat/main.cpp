@@ -2,6 +2,7 @@
 #include "controller/all.hpp"
 
 #include "module/all.hpp"
+#include "module/token.hpp"
 
 #include <mysqlx/xdevapi.h>
 
@@ -12,11 +13,14 @@
 #include <cpprest/json.h>
 #include <cpprest/uri.h>
 
+#include <algorithm>
+#include <csignal>
 #include <cstdio>
 #include <cstdlib>
 #include <exception>
 #include <fstream>
 #include <memory>
+#include <pthread.h>
 #include <string>
 #include <thread>
 
@@ -30,6 +34,16 @@ int main(int argc, char **argv) {
     exit(1);
   }
 
+  // Block termination & reload signals before any thread is spawned (the
+  // reaper, hashing & mail singletons below start their own), so that every
+  // thread inherits the mask and they are delivered only to sigwait
+  sigset_t signals;
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGINT);
+  sigaddset(&signals, SIGTERM);
+  sigaddset(&signals, SIGHUP);
+  pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
   auto ipAddress = module::getIpAddr(argv[1]);
   auto port = argv[2];
 
@@ -100,8 +114,158 @@ int main(int argc, char **argv) {
 
   auto &&ssl = module::secure::configSSL(sslKeyPath, sslCrtPath, sslDhPath);
 
+  /**
+   * session is optional
+   * secret : HMAC key of the session tokens, the same on every node behind
+   *          one load balancer. Empty or absent -> random key, tokens are
+   *          valid on this process only
+   * store : path prefix of the session snapshot and journal. Sessions and
+   *         logouts survive a restart; requires a fixed secret, since the
+   *         restored tokens are verified with it
+   */
+  auto sessionSecret = std::string{};
+  if (config.has_field("session") && config.at("session").has_field("secret")) {
+    sessionSecret = module::trim(config.at("session").at("secret").serialize());
+  }
+  module::TokenSigner::getInstance(sessionSecret);
+
+  if (config.has_field("session") && config.at("session").has_field("store")) {
+    if (sessionSecret.empty()) {
+      fprintf(stderr, "\n\nSession Store Needs A Session Secret\n\n");
+      exit(1);
+    }
+    const auto sessionStore =
+        module::trim(config.at("session").at("store").serialize());
+    auto sessionReaper = service::SessionReaper::getInstance(serverLogger);
+    for (const auto &[sessionId, expiredAt] :
+         dao::ServerSessionRepository::getInstance(serverLogger)
+             ->open(sessionStore)) {
+      sessionReaper->schedule(sessionId, expiredAt);
+    }
+  }
+
+  /**
+   * password is optional
+   * cost : PBKDF2 iterations of new hashes. Stored hashes of a lower cost
+   *        are upgraded on the next successful login
+   * workers, queue : threads hashing passwords and the logins that may wait
+   *                  for one. Logins beyond that are refused. Keep queue
+   *                  near workers * 10s (listener timeout) / time of a hash
+   */
+  uint64_t passwordCost = module::secure::kdfCost;
+  uint64_t passwordWorkers = 2;
+  uint64_t passwordQueue = 60;
+  if (config.has_field("password")) {
+    const auto passwordConfig = config.at("password");
+    if (passwordConfig.has_field("cost")) {
+      passwordCost = passwordConfig.at("cost").as_integer();
+    }
+    if (passwordConfig.has_field("workers")) {
+      passwordWorkers = passwordConfig.at("workers").as_integer();
+    }
+    if (passwordConfig.has_field("queue")) {
+      passwordQueue = passwordConfig.at("queue").as_integer();
+    }
+  }
+  module::PasswordHasher::getInstance(passwordCost, passwordWorkers,
+                                      passwordQueue);
+
+  /**
+   * login is optional
+   * account, address : { free, base, cap }. After `free` failed logins of
+   *                    one name/email or from one address, it is locked
+   *                    for `base` secs, doubling per failure up to `cap`
+   */
+  auto accountPolicy = module::LoginGuard::Policy{5, 1, 900};
+  auto addressPolicy = module::LoginGuard::Policy{50, 1, 900};
+  if (config.has_field("login")) {
+    const auto loginConfig = config.at("login");
+    for (auto &[name, policy] : {std::pair{"account", &accountPolicy},
+                                 std::pair{"address", &addressPolicy}}) {
+      if (loginConfig.has_field(name) == false) {
+        continue;
+      }
+      const auto policyConfig = loginConfig.at(name);
+      if (policyConfig.has_field("free")) {
+        policy->free = policyConfig.at("free").as_integer();
+      }
+      if (policyConfig.has_field("base")) {
+        policy->base = policyConfig.at("base").as_double();
+      }
+      if (policyConfig.has_field("cap")) {
+        policy->cap = policyConfig.at("cap").as_double();
+      }
+    }
+  }
+  module::LoginGuard::getInstance(accountPolicy, addressPolicy);
+
+  /**
+   * mail is optional
+   * host, port : SMTP relay that accepts mail from this host
+   * from, helo : envelope sender & the name given in EHLO
+   * workers, batch : sending threads & the mails sent per connection
+   */
+  auto relay = service::MailService::Relay{
+      "127.0.0.1", 25, "noreply@localhost", "localhost", 1, 32};
+  if (config.has_field("mail")) {
+    const auto mailConfig = config.at("mail");
+    if (mailConfig.has_field("host")) {
+      relay.host = module::trim(mailConfig.at("host").serialize());
+    }
+    if (mailConfig.has_field("port")) {
+      relay.port = mailConfig.at("port").as_integer();
+    }
+    if (mailConfig.has_field("from")) {
+      relay.from = module::trim(mailConfig.at("from").serialize());
+    }
+    if (mailConfig.has_field("helo")) {
+      relay.helo = module::trim(mailConfig.at("helo").serialize());
+    }
+    if (mailConfig.has_field("workers")) {
+      relay.workers = mailConfig.at("workers").as_integer();
+    }
+    if (mailConfig.has_field("batch")) {
+      relay.batch = mailConfig.at("batch").as_integer();
+    }
+  }
+  service::MailService::getInstance(serverLogger, connection, relay);
+
   serverLogger->info(fmt::v9::format("apiUri : {}", apiUri.to_string()));
 
+  /**
+   * server is optional
+   * workers : request-execution threads shared by every route
+   * concurrency, queue : default limit of a route
+   * rate, burst : default requests per second of a client on a route
+   * routes : { prefix : { concurrency, queue, rate, burst } } overriding
+   *          the default
+   */
+  uint64_t workers = std::max(1u, std::thread::hardware_concurrency());
+  uint64_t concurrency = 64;
+  uint64_t queue = 1024;
+  double rate = 0;
+  double burst = 0;
+  auto routesConfig = web::json::value::object();
+  if (config.has_field("server")) {
+    const auto serverConfig = config.at("server");
+    if (serverConfig.has_field("workers")) {
+      workers = serverConfig.at("workers").as_integer();
+    }
+    if (serverConfig.has_field("concurrency")) {
+      concurrency = serverConfig.at("concurrency").as_integer();
+    }
+    if (serverConfig.has_field("queue")) {
+      queue = serverConfig.at("queue").as_integer();
+    }
+    if (serverConfig.has_field("rate") && serverConfig.has_field("burst")) {
+      rate = serverConfig.at("rate").as_double();
+      burst = serverConfig.at("burst").as_double();
+    }
+    if (serverConfig.has_field("routes")) {
+      routesConfig = serverConfig.at("routes");
+    }
+  }
+
   try {
     auto companyController = controller::CompanyController::getInstance(
         apiUri, serverLogger, connection, ssl);
@@ -119,39 +283,57 @@ int main(int argc, char **argv) {
     auto invitationController = controller::InvitationController::getInstance(
         apiUri, serverLogger, connection, ssl);
 
-    auto companyThread =
-        std::thread(&controller::CompanyController::listen,
-                    std::dynamic_pointer_cast<controller::CompanyController>(
-                        companyController));
-
-    auto authThread = std::thread(
-        &controller::AuthController::listen,
-        std::dynamic_pointer_cast<controller::AuthController>(authController));
-
-    auto userThread = std::thread(
-        &controller::UserController::listen,
-        std::dynamic_pointer_cast<controller::UserController>(userController));
-
-    auto roomThread = std::thread(
-        &controller::RoomController::listen,
-        std::dynamic_pointer_cast<controller::RoomController>(roomController));
-
-    auto participantThread = std::thread(
-        &controller::ParticipantController::listen,
-        std::dynamic_pointer_cast<controller::ParticipantController>(
-            participantController));
-
-    auto invitationThread =
-        std::thread(&controller::InvitationController::listen,
-                    std::dynamic_pointer_cast<controller::InvitationController>(
-                        invitationController));
-
-    companyThread.join();
-    authThread.join();
-    userThread.join();
-    roomThread.join();
-    participantThread.join();
-    invitationThread.join();
+    auto metricsController = controller::MetricsController::getInstance(
+        apiUri, serverLogger, connection, ssl);
+
+    auto batchController = controller::BatchController::getInstance(
+        apiUri, serverLogger, connection, ssl);
+
+    auto pool = std::make_shared<module::WorkerPool>("request", workers);
+    auto router = controller::Router::getInstance(apiUri, serverLogger, ssl,
+                                                  pool, concurrency, queue);
+    router->throttle("/", rate, burst);
+    for (const auto &[prefix, limit] : routesConfig.as_object()) {
+      if (limit.has_field("concurrency") && limit.has_field("queue")) {
+        router->limit(prefix, limit.at("concurrency").as_integer(),
+                      limit.at("queue").as_integer());
+      }
+      if (limit.has_field("rate") && limit.has_field("burst")) {
+        router->throttle(prefix, limit.at("rate").as_double(),
+                         limit.at("burst").as_double());
+      }
+    }
+
+    companyController->route(router);
+    authController->route(router);
+    userController->route(router);
+    roomController->route(router);
+    participantController->route(router);
+    invitationController->route(router);
+    metricsController->route(router);
+    batchController->route(router);
+
+    router->open();
+
+    int received = 0;
+    while (sigwait(&signals, &received) == 0 && received == SIGHUP) {
+      // SIGHUP : reload the certificate, key & DH parameters in place
+      try {
+        module::TlsCredentials::getInstance(sslKeyPath, sslCrtPath, sslDhPath)
+            ->reload();
+        serverLogger->info(
+            fmt::v9::format("signal({}) : ssl reloaded", received));
+      } catch (const std::exception &e) {
+        serverLogger->error(
+            fmt::v9::format("signal({}) : {}", received, e.what()));
+      }
+    }
+    serverLogger->info(fmt::v9::format("signal({}) : shutdown", received));
+
+    router->close();
+    service::SessionReaper::getInstance(serverLogger)->stop();
+    module::PasswordHasher::getInstance()->stop();
+    service::MailService::getInstance(serverLogger, connection)->stop();
 
   } catch (const std::exception &e) {
     serverLogger->error(e.what());
@@ -1,7 +1,14 @@
 #pragma once
 
 #include "common.hpp"
+#include "compression.hpp"
 #include "connection.hpp"
+#include "coroutine.hpp"
 #include "exception.hpp"
+#include "guard.hpp"
+#include "hasher.hpp"
+#include "metrics.hpp"
 #include "secure.hpp"
-#include "explot.hpp"
\ No newline at end of file
+#include "validator.hpp"
+#include "explot.hpp"
+#include "worker.hpp"
\ No newline at end of file
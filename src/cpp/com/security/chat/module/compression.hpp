@@ -0,0 +1,122 @@
+#pragma once
+
+#include "exception.hpp"
+using namespace chat::module::exception;
+
+#include <fmt/core.h>
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace chat::module::compression {
+
+// 이보다 작은 body는 압축 비용이 전송 이득보다 크다
+constexpr uint64_t threshold = 1024;
+
+enum class Encoding { IDENTITY, GZIP, DEFLATE };
+
+std::string nameOf(Encoding encoding) {
+  switch (encoding) {
+  case Encoding::GZIP:
+    return "gzip";
+  case Encoding::DEFLATE:
+    return "deflate";
+  default:
+    return "identity";
+  }
+}
+
+Encoding negotiate(std::string acceptEncoding) {
+  /**
+   * Accept-Encoding: gzip;q=1.0, deflate;q=0.5, *;q=0
+   * The highest q wins, gzip before deflate on a tie. q=0 refuses a coding.
+   * `*` stands only for the codings not listed by name
+   */
+  std::transform(acceptEncoding.begin(), acceptEncoding.end(),
+                 acceptEncoding.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+
+  // q of gzip, deflate and * ; < 0 : not listed
+  double gzipQ = -1;
+  double deflateQ = -1;
+  double anyQ = -1;
+  size_t begin = 0;
+  while (begin < acceptEncoding.size()) {
+    auto end = acceptEncoding.find(',', begin);
+    if (end == std::string::npos) {
+      end = acceptEncoding.size();
+    }
+    auto coding = acceptEncoding.substr(begin, end - begin);
+    begin = end + 1;
+
+    double q = 1;
+    auto params = coding.find(';');
+    if (params != std::string::npos) {
+      auto qAt = coding.find("q=", params);
+      if (qAt != std::string::npos) {
+        q = std::atof(coding.c_str() + qAt + 2);
+      }
+      coding = coding.substr(0, params);
+    }
+    coding.erase(
+        std::remove_if(coding.begin(), coding.end(),
+                       [](unsigned char c) { return std::isspace(c); }),
+        coding.end());
+
+    if (coding == "gzip" || coding == "x-gzip") {
+      gzipQ = std::max(gzipQ, q);
+    } else if (coding == "deflate") {
+      deflateQ = std::max(deflateQ, q);
+    } else if (coding == "*") {
+      anyQ = std::max(anyQ, q);
+    }
+  }
+  if (gzipQ < 0) {
+    gzipQ = anyQ;
+  }
+  if (deflateQ < 0) {
+    deflateQ = anyQ;
+  }
+
+  if ((gzipQ > 0) && (gzipQ >= deflateQ)) {
+    return Encoding::GZIP;
+  } else if (deflateQ > 0) {
+    return Encoding::DEFLATE;
+  }
+  return Encoding::IDENTITY;
+}
+
+std::vector<unsigned char> compress(const std::string &body,
+                                    Encoding encoding) {
+  // gzip : gzip header, deflate : zlib header (RFC 9110 8.4.1)
+  int windowBits = (encoding == Encoding::GZIP) ? 15 + 16 : 15;
+
+  z_stream stream{};
+  if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, windowBits, 8,
+                   Z_DEFAULT_STRATEGY) != Z_OK) {
+    throw BusinessException(fmt::v9::format("compression init failed"));
+  }
+
+  // deflateBound includes the gzip/zlib wrapper chosen by deflateInit2
+  auto compressed =
+      std::vector<unsigned char>(deflateBound(&stream, body.size()));
+  stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(body.data()));
+  stream.avail_in = body.size();
+  stream.next_out = compressed.data();
+  stream.avail_out = compressed.size();
+
+  auto result = deflate(&stream, Z_FINISH);
+  deflateEnd(&stream);
+  if (result != Z_STREAM_END) {
+    throw BusinessException(fmt::v9::format("compression failed({})", result));
+  }
+  compressed.resize(stream.total_out);
+  return compressed;
+}
+} // namespace chat::module::compression
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "worker.hpp"
+
+#include <pplx/pplxtasks.h>
+
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <utility>
+
+namespace pplx {
+template <class T> auto operator co_await(task<T> awaited) {
+  /**
+   * co_await on a pplx task
+   * No thread is parked while the result is pending. The task's
+   * continuation hands the coroutine back to the WorkerPool it was suspended
+   * on, so the rest of a handler keeps to the pool its route was admitted
+   * to rather than the pplx scheduler. Outside of a pool, or once the pool
+   * has stopped, it is resumed in the continuation itself
+   */
+  struct Awaiter {
+    task<T> awaited;
+
+    bool await_ready() const { return awaited.is_done(); }
+    void await_suspend(std::coroutine_handle<> handle) const {
+      /**
+       * The continuation may resume the coroutine, which may finish and
+       * destroy this awaiter, before then() has returned. So then() is
+       * called on a copy of the task, the continuation captures everything
+       * it needs by value, and the awaiter must not be touched after then()
+       * is registered
+       */
+      auto pending = awaited;
+      auto pool = chat::module::WorkerPool::current();
+      pending.then([handle, pool](task<T>) {
+        auto resumeOn = pool.lock();
+        if ((resumeOn == nullptr) ||
+            (resumeOn->submit([handle]() { handle.resume(); }) == false)) {
+          handle.resume();
+        }
+      });
+    }
+    T await_resume() const { return awaited.get(); }
+  };
+  return Awaiter{std::move(awaited)};
+}
+} // namespace pplx
+
+template <class... ARGS>
+struct std::coroutine_traits<pplx::task<void>, ARGS...> {
+  /**
+   * Lets a function returning pplx::task<void> be written as a coroutine.
+   * The returned task completes when the coroutine body finishes
+   */
+  struct promise_type {
+    pplx::task_completion_event<void> done;
+
+    pplx::task<void> get_return_object() { return pplx::task<void>(done); }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() { done.set(); }
+    void unhandled_exception() { done.set_exception(std::current_exception()); }
+  };
+};
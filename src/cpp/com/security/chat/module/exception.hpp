@@ -61,6 +61,18 @@ public:
   ServiceException(std::string msg) : BusinessException(msg) {}
 };
 
+// a bounded queue is full; the caller may retry later
+class OverloadedException : public ServiceException {
+public:
+  OverloadedException(std::string msg) : ServiceException(msg) {}
+};
+
+// too many failed attempts; refused before doing any work
+class ThrottledException : public OverloadedException {
+public:
+  ThrottledException(std::string msg) : OverloadedException(msg) {}
+};
+
 class ControllerException : public BusinessException {
 public:
   ControllerException(std::string msg) : BusinessException(msg) {}
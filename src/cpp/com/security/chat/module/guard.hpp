@@ -0,0 +1,163 @@
+#pragma once
+
+#include "metrics.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace chat::module {
+
+class LoginGuard {
+  /**
+   * Failed logins per account and per source address
+   * After `free` failures a key is locked for `base` seconds, doubling with
+   * each further failure up to `cap`. Attempts on a locked key are refused
+   * before any DB lookup or hashing and are not counted themselves.
+   * A success clears the account but not the address, and failures older
+   * than `cap` are forgotten.
+   * Keys are spread over independently locked stripes like RateLimiter
+   */
+public:
+  using Clock = std::chrono::steady_clock;
+
+  struct Policy {
+    uint64_t free;
+    double base; // secs
+    double cap;  // secs
+  };
+
+  static std::shared_ptr<LoginGuard>
+  getInstance(Policy account = {5, 1, 900}, Policy address = {50, 1, 900}) {
+    // the parameters of the first call are kept
+    std::lock_guard<std::mutex> lock(createMutex);
+    if (instance == nullptr) {
+      instance = std::make_shared<LoginGuard>(account, address);
+    }
+    return instance;
+  }
+
+  LoginGuard(Policy account, Policy address)
+      : account(account), address(address),
+        failures(Metrics::getInstance()->at("login.failures")),
+        accountLockouts(
+            Metrics::getInstance()->at("login.lockouts.account")),
+        addressLockouts(
+            Metrics::getInstance()->at("login.lockouts.address")),
+        throttled(Metrics::getInstance()->at("login.throttled")) {}
+
+  bool admit(const std::string &accountKey, const std::string &addressKey) {
+    auto now = Clock::now();
+    if (isLocked(accountKey, now) || isLocked(addressKey, now)) {
+      throttled.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    return true;
+  }
+
+  void fail(const std::string &accountKey, const std::string &addressKey) {
+    auto now = Clock::now();
+    failures.fetch_add(1, std::memory_order_relaxed);
+    fail(accountKey, account, accountLockouts, now);
+    fail(addressKey, address, addressLockouts, now);
+  }
+
+  void succeed(const std::string &accountKey) {
+    auto &stripe = stripeOf(accountKey);
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    stripe.entries.erase(accountKey);
+  }
+
+private:
+  struct Entry {
+    uint64_t failures;
+    Clock::time_point lockedUntil;
+    Clock::time_point forgetAt;
+  };
+
+  struct Stripe {
+    std::mutex mutex;
+    std::unordered_map<std::string, Entry> entries;
+    uint64_t sweepAt = sweepFloor;
+  };
+
+  Stripe &stripeOf(const std::string &key) {
+    return stripes[std::hash<std::string>{}(key) % stripeCount];
+  }
+
+  bool isLocked(const std::string &key, Clock::time_point now) {
+    auto &stripe = stripeOf(key);
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    auto entry = stripe.entries.find(key);
+    return (entry != stripe.entries.end()) &&
+           (now < entry->second.lockedUntil);
+  }
+
+  void fail(const std::string &key, const Policy &policy,
+            Metrics::V &lockouts, Clock::time_point now) {
+    auto &stripe = stripeOf(key);
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    if (stripe.entries.size() >= stripe.sweepAt) {
+      sweep(stripe, now);
+    }
+
+    auto &entry =
+        stripe.entries.try_emplace(key, Entry{0, now, now}).first->second;
+    if (entry.forgetAt <= now) {
+      entry.failures = 0;
+    }
+    entry.failures += 1;
+
+    if (entry.failures > policy.free) {
+      // base, 2 * base, 4 * base ... cap
+      auto exponent = std::min<uint64_t>(entry.failures - policy.free - 1, 32);
+      auto window = std::min(policy.cap, std::ldexp(policy.base, exponent));
+      entry.lockedUntil =
+          now + std::chrono::duration_cast<Clock::duration>(
+                    std::chrono::duration<double>(window));
+      lockouts.fetch_add(1, std::memory_order_relaxed);
+    }
+    entry.forgetAt =
+        std::max(entry.lockedUntil,
+                 now + std::chrono::duration_cast<Clock::duration>(
+                           std::chrono::duration<double>(policy.cap)));
+  }
+
+  static void sweep(Stripe &stripe, Clock::time_point now) {
+    for (auto iter = stripe.entries.begin(); iter != stripe.entries.end();) {
+      if (iter->second.forgetAt <= now) {
+        iter = stripe.entries.erase(iter);
+      } else {
+        ++iter;
+      }
+    }
+    stripe.sweepAt = std::max(sweepFloor, stripe.entries.size() * 2);
+  }
+
+  static constexpr uint64_t stripeCount = 64;
+  static constexpr uint64_t sweepFloor = 1024;
+
+  static std::shared_ptr<LoginGuard> instance;
+  static std::mutex createMutex;
+
+  Policy account;
+  Policy address;
+  Metrics::V &failures;
+  Metrics::V &accountLockouts;
+  Metrics::V &addressLockouts;
+  Metrics::V &throttled;
+  std::array<Stripe, stripeCount> stripes;
+
+  LoginGuard() = delete;
+};
+
+std::shared_ptr<LoginGuard> LoginGuard::instance = nullptr;
+std::mutex LoginGuard::createMutex{};
+} // namespace chat::module
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "exception.hpp"
+#include "secure.hpp"
+#include "worker.hpp"
+using namespace chat::module::exception;
+
+#include <fmt/core.h>
+
+#include <pplx/pplxtasks.h>
+
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace chat::module {
+
+class PasswordHasher {
+  /**
+   * Password hashing off the request threads
+   * Hashes run on a WorkerPool of their own behind one Lane: `workers` at
+   * once, up to `queue` waiting, the rest refused with OverloadedException.
+   * A login storm therefore takes at most `workers` cores, and other routes
+   * keep theirs
+   *
+   * One hash at the default cost takes about 0.33s, so `queue` is sized to
+   * what `workers` can hash within the listener timeout (10s); about 60 for
+   * two workers. A job still waiting past `deadline` has lost its client,
+   * and is failed without hashing
+   */
+public:
+  static std::shared_ptr<PasswordHasher>
+  getInstance(uint32_t cost = secure::kdfCost, uint64_t workers = 2,
+              uint64_t queue = 60,
+              std::chrono::seconds deadline = std::chrono::seconds(10)) {
+    // the parameters of the first call are kept
+    std::lock_guard<std::mutex> lock(createMutex);
+    if (instance == nullptr) {
+      instance =
+          std::make_shared<PasswordHasher>(cost, workers, queue, deadline);
+    }
+    return instance;
+  }
+
+  PasswordHasher(uint32_t cost, uint64_t workers, uint64_t queue,
+                 std::chrono::seconds deadline)
+      : cost(cost), deadline(deadline),
+        pool(std::make_shared<WorkerPool>("hash", workers)),
+        lane("hash", pool, workers, queue),
+        expiredMetric(Metrics::getInstance()->at("hash.expired")) {}
+
+  ~PasswordHasher() { pool->stop(); }
+
+  // cost of new hashes; rows below it are rehashed on login
+  uint32_t getCost() const { return cost; }
+
+  pplx::task<std::string> hash(std::string password, std::string salt) {
+    return run<std::string>([password, salt, cost = this->cost]() {
+      return secure::hash(password, salt, cost);
+    });
+  }
+
+  pplx::task<bool> compare(std::string receivedPw, std::string storedPw,
+                           std::string salt, uint32_t cost) {
+    return run<bool>([receivedPw, storedPw, salt, cost]() {
+      return secure::compare(receivedPw, storedPw, salt, cost);
+    });
+  }
+
+  void stop() { pool->stop(); }
+
+private:
+  template <typename T> pplx::task<T> run(std::function<T()> work) {
+    auto done = pplx::task_completion_event<T>{};
+    auto expiredAt = std::chrono::steady_clock::now() + deadline;
+    if (lane.submit([this, work, done, expiredAt](Lane::Done finish) {
+          if (std::chrono::steady_clock::now() > expiredAt) {
+            expiredMetric.fetch_add(1, std::memory_order_relaxed);
+            done.set_exception(std::make_exception_ptr(OverloadedException(
+                fmt::v9::format("PasswordHasher : waited past the deadline"))));
+            finish();
+            return;
+          }
+          try {
+            done.set(work());
+          } catch (...) {
+            done.set_exception(std::current_exception());
+          }
+          finish();
+        },
+        [done]() {
+          done.set_exception(std::make_exception_ptr(OverloadedException(
+              fmt::v9::format("PasswordHasher : hashing pool is stopped"))));
+        }) == false) {
+      throw OverloadedException(
+          fmt::v9::format("PasswordHasher : hashing queue is full"));
+    }
+    return pplx::task<T>(done);
+  }
+
+  static std::shared_ptr<PasswordHasher> instance;
+  static std::mutex createMutex;
+
+  uint32_t cost;
+  std::chrono::seconds deadline;
+  std::shared_ptr<WorkerPool> pool;
+  Lane lane;
+  Metrics::V &expiredMetric;
+
+  PasswordHasher() = delete;
+};
+
+std::shared_ptr<PasswordHasher> PasswordHasher::instance = nullptr;
+std::mutex PasswordHasher::createMutex{};
+} // namespace chat::module
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace chat::module {
+
+class RateLimiter {
+  /**
+   * Token buckets keyed by caller (session id, remote address ...)
+   * A bucket holds up to `burst` tokens and refills at `rate` per second;
+   * each request takes one. Buckets are spread over independently locked
+   * stripes, so callers with different keys rarely contend.
+   * A bucket that has refilled completely is indistinguishable from a new
+   * one, so idle buckets are dropped when a stripe grows
+   */
+public:
+  using Clock = std::chrono::steady_clock;
+
+  struct Budget {
+    double rate;
+    double burst;
+  };
+
+  RateLimiter() = default;
+
+  bool acquire(const std::string &key, const Budget &budget) {
+    if (budget.rate <= 0) {
+      // unlimited
+      return true;
+    }
+    auto &stripe = stripes[std::hash<std::string>{}(key) % stripeCount];
+    auto now = Clock::now();
+
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    if (stripe.buckets.size() >= stripe.sweepAt) {
+      sweep(stripe, now);
+    }
+
+    auto &bucket =
+        stripe.buckets.try_emplace(key, Bucket{budget.burst, now, now})
+            .first->second;
+    std::chrono::duration<double> elapsed = now - bucket.updatedAt;
+    bucket.tokens =
+        std::min(budget.burst, bucket.tokens + elapsed.count() * budget.rate);
+    bucket.updatedAt = now;
+
+    bool acquired = (bucket.tokens >= 1);
+    if (acquired) {
+      bucket.tokens -= 1;
+    }
+    bucket.fullAt =
+        now + std::chrono::duration_cast<Clock::duration>(
+                  std::chrono::duration<double>((budget.burst - bucket.tokens) /
+                                                budget.rate));
+    return acquired;
+  }
+
+private:
+  struct Bucket {
+    double tokens;
+    Clock::time_point updatedAt;
+    Clock::time_point fullAt;
+  };
+
+  struct Stripe {
+    std::mutex mutex;
+    std::unordered_map<std::string, Bucket> buckets;
+    uint64_t sweepAt = sweepFloor;
+  };
+
+  static void sweep(Stripe &stripe, Clock::time_point now) {
+    for (auto iter = stripe.buckets.begin(); iter != stripe.buckets.end();) {
+      if (iter->second.fullAt <= now) {
+        iter = stripe.buckets.erase(iter);
+      } else {
+        ++iter;
+      }
+    }
+    stripe.sweepAt = std::max(sweepFloor, stripe.buckets.size() * 2);
+  }
+
+  static constexpr uint64_t stripeCount = 64;
+  static constexpr uint64_t sweepFloor = 1024;
+
+  std::array<Stripe, stripeCount> stripes;
+};
+} // namespace chat::module
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace chat::module {
+
+class Metrics {
+  /**
+   * Process-wide named counters & gauges
+   * A metric is created on first use and lives until exit, so the returned
+   * reference may be cached by the caller
+   */
+public:
+  using V = std::atomic<int64_t>;
+
+  static std::shared_ptr<Metrics> getInstance() {
+    std::lock_guard<std::mutex> lock(createMutex);
+    if (instance == nullptr) {
+      instance = std::make_shared<Metrics>();
+    }
+    return instance;
+  }
+
+  V &at(const std::string &name) {
+    std::lock_guard<std::mutex> lock(metricMutex);
+    auto &metric = metrics[name];
+    if (metric == nullptr) {
+      metric = std::make_unique<V>(0);
+    }
+    return *metric;
+  }
+
+  void add(const std::string &name, int64_t delta = 1) {
+    at(name).fetch_add(delta, std::memory_order_relaxed);
+  }
+
+  void set(const std::string &name, int64_t value) {
+    at(name).store(value, std::memory_order_relaxed);
+  }
+
+  std::map<std::string, int64_t> snapshot() {
+    std::lock_guard<std::mutex> lock(metricMutex);
+    auto values = std::map<std::string, int64_t>{};
+    for (const auto &[name, metric] : metrics) {
+      values.emplace(name, metric->load(std::memory_order_relaxed));
+    }
+    return values;
+  }
+
+  Metrics() = default;
+
+private:
+  static std::shared_ptr<Metrics> instance;
+  static std::mutex createMutex;
+
+  std::mutex metricMutex;
+  std::map<std::string, std::unique_ptr<V>> metrics;
+};
+
+std::shared_ptr<Metrics> Metrics::instance = nullptr;
+std::mutex Metrics::createMutex{};
+} // namespace chat::module
@@ -1,69 +1,161 @@
 #pragma once
 
 #include "exception.hpp"
+#include "tls.hpp"
+#include "validator.hpp"
 using namespace chat::module::exception;
 
 #include <cpprest/http_listener.h>
 
+#include <fmt/core.h>
+
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+
 #include <algorithm>
-#include <cctype>
+#include <array>
+#include <cstring>
 #include <functional>
-#include <limits>
-#include <random>
-#include <regex>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace chat::module::secure {
 
-std::string hash(std::string password, std::string salt) {
-  constexpr uint8_t pepper = 10;
-  static std::hash<std::string> hash{};
+// PBKDF2-HMAC-SHA256 iterations of a new hash (OWASP 2023)
+constexpr uint32_t kdfCost = 600000;
+
+std::string hash(std::string password, std::string salt, uint32_t cost) {
+  /**
+   * cost : PBKDF2-HMAC-SHA256 iterations, 64 hex digits
+   * cost 0 is the former 10 rounds of std::hash, kept only to verify the
+   * rows written before; they are rehashed on the next login
+   */
+  if (cost == 0) {
+    constexpr uint8_t pepper = 10;
+    static std::hash<std::string> hash{};
+
+    auto hashedPw = password + salt;
+    for (auto i = 0; i < pepper; ++i) {
+      hashedPw = std::to_string(hash(hashedPw + salt));
+    }
+    return hashedPw;
+  }
 
-  auto hashedPw = password + salt;
-  for (auto i = 0; i < pepper; ++i) {
-    hashedPw = std::to_string(hash(hashedPw + salt));
+  std::array<unsigned char, 32> derived;
+  if (PKCS5_PBKDF2_HMAC(password.data(), password.size(),
+                        reinterpret_cast<const unsigned char *>(salt.data()),
+                        salt.size(), cost, EVP_sha256(), derived.size(),
+                        derived.data()) != 1) {
+    throw BusinessException(fmt::v9::format("hash : PBKDF2 failed"));
   }
+  static constexpr char digits[] = "0123456789abcdef";
+  std::string hashedPw(derived.size() * 2, 0);
+  for (size_t i = 0; i < derived.size(); ++i) {
+    hashedPw[i * 2] = digits[derived[i] >> 4];
+    hashedPw[i * 2 + 1] = digits[derived[i] & 0x0f];
+  }
+  OPENSSL_cleanse(derived.data(), derived.size());
   return hashedPw;
 }
-bool compare(std::string receivedPw, std::string storedPw, std::string salt) {
-  constexpr uint8_t pepper = 10;
-  static std::hash<std::string> hash{};
+bool compare(std::string receivedPw, std::string storedPw, std::string salt,
+             uint32_t cost) {
+  auto hashedReceivedPw = hash(receivedPw, salt, cost);
+  // constant time : how much of the hash matched must not leak
+  return (hashedReceivedPw.size() == storedPw.size()) &&
+         (CRYPTO_memcmp(hashedReceivedPw.data(), storedPw.data(),
+                        storedPw.size()) == 0);
+}
 
-  auto hashedReceivedPw = receivedPw + salt;
-  for (auto i = 0; i < pepper; ++i) {
-    hashedReceivedPw = std::to_string(hash(hashedReceivedPw + salt));
+class RandomBuffer {
+  /**
+   * Bytes of the OpenSSL DRBG, drawn 4KB at a time into a per-thread buffer
+   * A salt, a code or a session key then costs a copy instead of a
+   * RAND_bytes call, and threads never share (or lock) a buffer.
+   * Handed-out bytes are wiped from the buffer
+   */
+public:
+  static RandomBuffer &local() {
+    thread_local RandomBuffer buffer;
+    return buffer;
   }
-  return hashedReceivedPw == storedPw;
-}
+
+  void fill(unsigned char *out, size_t size) {
+    while (size > 0) {
+      if (used == bytes.size()) {
+        refill();
+      }
+      auto count = std::min(size, bytes.size() - used);
+      std::memcpy(out, bytes.data() + used, count);
+      OPENSSL_cleanse(bytes.data() + used, count);
+      used += count;
+      out += count;
+      size -= count;
+    }
+  }
+
+private:
+  RandomBuffer() : used(capacity) {}
+
+  void refill() {
+    if (RAND_bytes(bytes.data(), bytes.size()) != 1) {
+      throw BusinessException(fmt::v9::format("RandomBuffer : no entropy"));
+    }
+    used = 0;
+  }
+
+  static constexpr size_t capacity = 4096;
+
+  std::array<unsigned char, capacity> bytes;
+  size_t used;
+};
 
 uint64_t generateRandomNumber() {
-  std::random_device rd;
-  std::mt19937_64 gen(rd());
-  std::uniform_int_distribution<uint64_t> distrib(
-      std::numeric_limits<uint64_t>::min(),
-      std::numeric_limits<uint64_t>::max());
-  return distrib(gen);
+  uint64_t number;
+  RandomBuffer::local().fill(reinterpret_cast<unsigned char *>(&number),
+                             sizeof(number));
+  return number;
 }
 
 std::string generateFixedLengthCode(uint64_t length) {
+  /**
+   * [0-9A-Za-z]{length}, uniformly
+   * A random byte below 248 (= 62 * 4) maps to charset[byte % 62]; the
+   * other 8 values are dropped, so no character is more likely than another
+   */
   static constexpr char charset[] = {
       '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C',
       'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'L', 'M', 'N', 'O', 'P',
       'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X', 'Y', 'Z', 'a', 'b', 'c',
       'd', 'e', 'f', 'g', 'h', 'i', 'j', 'k', 'l', 'm', 'n', 'o', 'p',
       'q', 'r', 's', 't', 'u', 'v', 'w', 'x', 'y', 'z'};
+  static constexpr unsigned char limit = sizeof(charset) * 4;
 
-  std::default_random_engine rng(std::random_device{}());
-  std::uniform_int_distribution<> dist(0, sizeof(charset) - 1);
-  auto randchar = [&dist, &rng]() { return charset[dist(rng)]; };
+  auto &random = RandomBuffer::local();
+  std::array<unsigned char, 256> chunk;
   std::string str(length, 0);
-  std::generate_n(str.begin(), length, randchar);
+  uint64_t filled = 0;
+  while (filled < length) {
+    // 1/32 more than needed covers the dropped bytes most of the time
+    auto missing = length - filled;
+    auto count = std::min<uint64_t>(chunk.size(), missing + missing / 32 + 1);
+    random.fill(chunk.data(), count);
+    for (uint64_t i = 0; (i < count) && (filled < length); ++i) {
+      if (chunk[i] < limit) {
+        str[filled++] = charset[chunk[i] % sizeof(charset)];
+      }
+    }
+  }
+  OPENSSL_cleanse(chunk.data(), chunk.size());
   return str;
 }
 
 decltype(auto) configSSL(std::string keyPath, std::string crtPath,
                          std::string dhPath) {
+  // PEM files are parsed here once, not on every connection
+  auto credentials = TlsCredentials::getInstance(keyPath, crtPath, dhPath);
+
   auto config = web::http::experimental::listener::http_listener_config{};
   config.set_ssl_context_callback([=](boost::asio::ssl::context &ctx) {
     ctx.set_options(boost::asio::ssl::context::default_workarounds |
@@ -72,9 +164,22 @@ decltype(auto) configSSL(std::string keyPath, std::string crtPath,
                     boost::asio::ssl::context::no_tlsv1_1 |
                     boost::asio::ssl::context::single_dh_use);
 
-    ctx.use_certificate_chain_file(crtPath);
-    ctx.use_private_key_file(keyPath, boost::asio::ssl::context::pem);
-    ctx.use_tmp_dh_file(dhPath);
+    auto handle = ctx.native_handle();
+    // DH는 ECDHE를 지원하지 않는 client를 위해서만 남겨둔다
+    credentials->apply(handle);
+
+    SSL_CTX_set1_groups_list(handle, "X25519:P-256:P-384");
+    SSL_CTX_set_cipher_list(handle, "ECDHE-ECDSA-AES128-GCM-SHA256:"
+                                    "ECDHE-RSA-AES128-GCM-SHA256:"
+                                    "ECDHE-ECDSA-AES256-GCM-SHA384:"
+                                    "ECDHE-RSA-AES256-GCM-SHA384:"
+                                    "ECDHE-ECDSA-CHACHA20-POLY1305:"
+                                    "ECDHE-RSA-CHACHA20-POLY1305:"
+                                    "DHE-RSA-AES128-GCM-SHA256:"
+                                    "DHE-RSA-AES256-GCM-SHA384");
+    SSL_CTX_set_options(handle, SSL_OP_CIPHER_SERVER_PREFERENCE);
+
+    TlsResumption::getInstance()->attach(handle);
   });
   config.set_timeout(utility::seconds(10));
 
@@ -82,18 +187,9 @@ decltype(auto) configSSL(std::string keyPath, std::string crtPath,
 }
 
 // sql injection을 방지하기 위해, userInput을 검증한다
-bool verifyUserInput(const std::string &input) {
-  return std::count_if(input.begin(), input.end(), [](unsigned char c) {
-           return std::isalpha(c) || std::isdigit(c);
-         }) == input.size();
+bool verifyUserInput(std::string_view input) {
+  return validator::isAlnum(input);
 }
 
-bool verifyEmail(const std::string &email) {
-  // Regular expression definition
-  const std::regex pattern("(\\w+)(\\.|_)?(\\w*)@(\\w+)(\\.(\\w+))+");
-
-  // Match the string pattern
-  // with regular expression
-  return std::regex_match(email, pattern);
-}
+bool verifyEmail(std::string_view email) { return validator::isEmail(email); }
 } // namespace chat::module::secure
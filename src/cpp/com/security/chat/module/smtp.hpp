@@ -0,0 +1,289 @@
+#pragma once
+
+#include "exception.hpp"
+using namespace chat::module::exception;
+
+#include <fmt/core.h>
+
+#include <openssl/evp.h>
+
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <exception>
+#include <string>
+#include <vector>
+
+namespace chat::module {
+
+class SmtpClient {
+  /**
+   * Minimal SMTP (RFC 5321) client of a local relay
+   * One connection carries many mails : open() once, send() per mail, then
+   * close() with QUIT. No TLS nor AUTH; the relay is expected to accept
+   * mail from this host, as postfix does for its mynetworks.
+   * I/O & protocol errors throw; a refused mail is returned as its Reply
+   * and the connection stays usable
+   */
+public:
+  struct Reply {
+    int code;
+    std::string text;
+
+    bool isOk() const { return code / 100 == 2; }
+    // 5xx : retrying the same mail will not help
+    bool isPermanent() const { return code / 100 == 5; }
+  };
+
+  SmtpClient(std::string host, uint16_t port, std::string helo,
+             int timeout = 10)
+      : host(host), port(port), helo(helo), timeout(timeout), fd(-1) {}
+
+  ~SmtpClient() { disconnect(); }
+
+  SmtpClient(const SmtpClient &) = delete;
+  SmtpClient &operator=(const SmtpClient &) = delete;
+
+  void open() {
+    connect();
+    expect(read(), 220, "greeting");
+    auto reply = command(fmt::v9::format("EHLO {}", helo));
+    if (reply.isOk() == false) {
+      // RFC 821 relay
+      reply = command(fmt::v9::format("HELO {}", helo));
+    }
+    expect(reply, 250, "HELO");
+  }
+
+  Reply send(const std::string &from, const std::string &to,
+             const std::string &subject, const std::string &body) {
+    auto reply = command(fmt::v9::format("MAIL FROM:<{}>", from));
+    if (reply.isOk()) {
+      reply = command(fmt::v9::format("RCPT TO:<{}>", to));
+    }
+    if (reply.isOk()) {
+      reply = command("DATA");
+      if (reply.code == 354) {
+        write(message(from, to, subject, body));
+        reply = read();
+      }
+    }
+    if (reply.isOk() == false) {
+      // drop the half-sent envelope and keep the connection for the next
+      expect(command("RSET"), 250, "RSET");
+    }
+    return reply;
+  }
+
+  void close() {
+    if (fd < 0) {
+      return;
+    }
+    try {
+      command("QUIT");
+    } catch (const std::exception &e) {
+      // the relay may hang up first
+    }
+    disconnect();
+  }
+
+private:
+  void connect() {
+    auto hints = addrinfo{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo *addresses = nullptr;
+    auto error = getaddrinfo(host.c_str(), std::to_string(port).c_str(),
+                             &hints, &addresses);
+    if (error != 0) {
+      throw BusinessException(fmt::v9::format(
+          "SmtpClient : {}:{} {}", host, port, gai_strerror(error)));
+    }
+
+    // connect, send & recv all give up after `timeout` secs
+    auto limit = timeval{timeout, 0};
+    for (auto address = addresses; address != nullptr;
+         address = address->ai_next) {
+      fd = socket(address->ai_family, address->ai_socktype,
+                  address->ai_protocol);
+      if (fd < 0) {
+        continue;
+      }
+      setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &limit, sizeof(limit));
+      setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &limit, sizeof(limit));
+      if (::connect(fd, address->ai_addr, address->ai_addrlen) == 0) {
+        break;
+      }
+      disconnect();
+    }
+    freeaddrinfo(addresses);
+    if (fd < 0) {
+      throw BusinessException(fmt::v9::format(
+          "SmtpClient : cannot connect {}:{} ({})", host, port,
+          std::strerror(errno)));
+    }
+  }
+
+  void disconnect() {
+    if (fd >= 0) {
+      ::close(fd);
+      fd = -1;
+    }
+    buffer.clear();
+  }
+
+  Reply command(const std::string &line) {
+    write(line + "\r\n");
+    return read();
+  }
+
+  void write(const std::string &data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+      auto count =
+          ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+      if (count < 0 && errno == EINTR) {
+        continue;
+      }
+      if (count <= 0) {
+        throw BusinessException(fmt::v9::format(
+            "SmtpClient : send failed ({})", std::strerror(errno)));
+      }
+      sent += count;
+    }
+  }
+
+  std::string readLine() {
+    while (true) {
+      auto end = buffer.find("\r\n");
+      if (end != std::string::npos) {
+        auto line = buffer.substr(0, end);
+        buffer.erase(0, end + 2);
+        return line;
+      }
+      char chunk[512];
+      auto count = ::recv(fd, chunk, sizeof(chunk), 0);
+      if (count < 0 && errno == EINTR) {
+        continue;
+      }
+      if (count <= 0) {
+        throw BusinessException(fmt::v9::format(
+            "SmtpClient : connection closed ({})",
+            count == 0 ? "eof" : std::strerror(errno)));
+      }
+      buffer.append(chunk, count);
+    }
+  }
+
+  Reply read() {
+    // "250-first\r\n250-second\r\n250 last\r\n" is one reply
+    auto reply = Reply{0, ""};
+    while (true) {
+      auto line = readLine();
+      if (line.size() < 3) {
+        throw BusinessException(
+            fmt::v9::format("SmtpClient : malformed reply '{}'", line));
+      }
+      reply.code = std::atoi(line.substr(0, 3).c_str());
+      reply.text += line.size() > 4 ? line.substr(4) : "";
+      if (line.size() == 3 || line[3] != '-') {
+        return reply;
+      }
+      reply.text += " ";
+    }
+  }
+
+  void expect(const Reply &reply, int code, const std::string &step) {
+    if (reply.code != code) {
+      throw BusinessException(fmt::v9::format("SmtpClient : {} -> {} {}",
+                                              step, reply.code, reply.text));
+    }
+  }
+
+  static std::string header(const std::string &value) {
+    /**
+     * CR & LF would start a new header; non-ASCII text is sent as an
+     * RFC 2047 encoded-word
+     */
+    auto line = std::string{};
+    bool ascii = true;
+    for (unsigned char c : value) {
+      if (c == '\r' || c == '\n') {
+        continue;
+      }
+      ascii = ascii && (c < 0x80);
+      line.push_back(c);
+    }
+    if (ascii) {
+      return line;
+    }
+    auto encoded = std::vector<unsigned char>(4 * ((line.size() + 2) / 3) + 1);
+    auto length = EVP_EncodeBlock(
+        encoded.data(), reinterpret_cast<const unsigned char *>(line.data()),
+        line.size());
+    return fmt::v9::format(
+        "=?UTF-8?B?{}?=",
+        std::string(reinterpret_cast<char *>(encoded.data()), length));
+  }
+
+  std::string message(const std::string &from, const std::string &to,
+                      const std::string &subject,
+                      const std::string &body) const {
+    // localtime_r : several mail workers format at once
+    char date[64];
+    auto now = std::time(nullptr);
+    auto local = tm{};
+    localtime_r(&now, &local);
+    std::strftime(date, sizeof(date), "%a, %d %b %Y %H:%M:%S %z", &local);
+
+    auto data = fmt::v9::format("From: <{}>\r\n"
+                                "To: <{}>\r\n"
+                                "Subject: {}\r\n"
+                                "Date: {}\r\n"
+                                "MIME-Version: 1.0\r\n"
+                                "Content-Type: text/plain; charset=UTF-8\r\n"
+                                "Content-Transfer-Encoding: 8bit\r\n"
+                                "\r\n",
+                                header(from), header(to), header(subject),
+                                date);
+
+    // bare LF -> CRLF, and a leading '.' is doubled (RFC 5321 4.5.2)
+    bool lineStart = true;
+    for (size_t i = 0; i < body.size(); ++i) {
+      auto c = body[i];
+      if (lineStart && c == '.') {
+        data.push_back('.');
+      }
+      if (c == '\r' && i + 1 < body.size() && body[i + 1] == '\n') {
+        continue;
+      }
+      if (c == '\n' || c == '\r') {
+        data.append("\r\n");
+        lineStart = true;
+        continue;
+      }
+      data.push_back(c);
+      lineStart = false;
+    }
+    if (lineStart == false) {
+      data.append("\r\n");
+    }
+    data.append(".\r\n");
+    return data;
+  }
+
+  std::string host;
+  uint16_t port;
+  std::string helo;
+  int timeout;
+  int fd;
+  std::string buffer;
+};
+} // namespace chat::module
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <ctime>
+#include <utility>
+#include <vector>
+
+namespace chat::module {
+
+class TimingWheel {
+  /**
+   * Hierarchical timing wheel with a resolution of one second
+   * Level n has `slotCount` slots of slotCount^n seconds each, so 4 levels
+   * cover slotCount^4 seconds (~194 days); anything farther waits in the
+   * last slot of the top level and is placed again when that slot comes up.
+   *
+   * schedule() is O(1). advance() fires each entry once and moves it down
+   * at most once per level, so expiry is O(1) amortized per entry.
+   * Not synchronized; the owner serializes calls
+   */
+public:
+  using Key = uint64_t;
+
+  explicit TimingWheel(time_t now) : current(now), count(0) {}
+
+  void schedule(Key key, time_t at) {
+    // the slot of `current` has already fired : due entries fire next tick
+    place(Entry{key, std::max(at, current + 1)});
+  }
+
+  template <typename F> void advance(time_t now, F &&expire) {
+    /**
+     * expire(key) is called for every entry due at or before `now`
+     */
+    while (current < now) {
+      ++current;
+      // higher levels first, so that their entries can land in the slots
+      // cascaded right after them
+      for (size_t level = levelCount - 1; level > 0; --level) {
+        if (uint64_t(current) % spanOf(level - 1) == 0) {
+          cascade(level);
+        }
+      }
+
+      auto due = std::vector<Entry>{};
+      due.swap(slotOf(0, current));
+      count -= due.size();
+      for (const auto &entry : due) {
+        expire(entry.key);
+      }
+    }
+  }
+
+  uint64_t size() const { return count; }
+
+private:
+  struct Entry {
+    Key key;
+    time_t at;
+  };
+
+  static constexpr size_t levelCount = 4;
+  static constexpr uint64_t slotBits = 6;
+  static constexpr uint64_t slotCount = uint64_t(1) << slotBits;
+
+  // seconds covered by the slots of levels [0, level]
+  static constexpr uint64_t spanOf(size_t level) {
+    return uint64_t(1) << (slotBits * (level + 1));
+  }
+
+  std::vector<Entry> &slotOf(size_t level, time_t at) {
+    return slots[level][(uint64_t(at) >> (slotBits * level)) % slotCount];
+  }
+
+  void place(Entry entry) {
+    auto slotAt = std::max(entry.at, current);
+    auto delta = uint64_t(slotAt - current);
+
+    size_t level = 0;
+    while ((level + 1 < levelCount) && (delta >= spanOf(level))) {
+      ++level;
+    }
+    if (delta >= spanOf(level)) {
+      // beyond the horizon : park in the farthest slot of the top level
+      slotAt = current + spanOf(level) - 1;
+    }
+    slotOf(level, slotAt).emplace_back(entry);
+    ++count;
+  }
+
+  void cascade(size_t level) {
+    // entries due at `current` land in the level 0 slot about to fire
+    auto moved = std::vector<Entry>{};
+    moved.swap(slotOf(level, current));
+    count -= moved.size();
+    for (const auto &entry : moved) {
+      place(entry);
+    }
+  }
+
+  time_t current;
+  uint64_t count;
+  std::array<std::array<std::vector<Entry>, slotCount>, levelCount> slots;
+};
+} // namespace chat::module
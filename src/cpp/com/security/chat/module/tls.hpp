@@ -0,0 +1,426 @@
+#pragma once
+
+#include "exception.hpp"
+#include "metrics.hpp"
+using namespace chat::module::exception;
+
+#include <fmt/core.h>
+
+#include <openssl/core_names.h>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/rand.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace chat::module {
+
+class TlsResumption {
+  /**
+   * Process-wide TLS resumption state
+   * The listener builds a fresh SSL_CTX for every connection, so neither
+   * OpenSSL's internal session cache nor its per-context ticket key can be
+   * shared between connections. Both are kept here instead and attached to
+   * each new context
+   *  - session-ID cache : serialized sessions, bounded & expired in order
+   *  - session tickets : AES-256-CBC / HMAC-SHA256 keys, rotated by age
+   *  - handshake metrics : full vs resumed, latency
+   */
+public:
+  using Clock = std::chrono::steady_clock;
+
+  static std::shared_ptr<TlsResumption> getInstance() {
+    std::lock_guard<std::mutex> lock(createMutex);
+    if (instance == nullptr) {
+      instance = std::make_shared<TlsResumption>();
+    }
+    return instance;
+  }
+  TlsResumption()
+      : fullMetric(Metrics::getInstance()->at("tls.handshake.full")),
+        resumedMetric(Metrics::getInstance()->at("tls.handshake.resumed")),
+        latencyTotalMetric(
+            Metrics::getInstance()->at("tls.handshake.us_total")),
+        latencyMaxMetric(Metrics::getInstance()->at("tls.handshake.us_max")),
+        cacheSizeMetric(Metrics::getInstance()->at("tls.session_cache.size")),
+        rotatedMetric(Metrics::getInstance()->at("tls.ticket_key.rotated")) {
+    startIndex = SSL_get_ex_new_index(0, nullptr, nullptr, nullptr,
+                                      &TlsResumption::freeStart);
+  }
+
+  void attach(SSL_CTX *ctx) {
+    static constexpr unsigned char sessionIdContext[] = "secure-chat";
+
+    SSL_CTX_set_session_id_context(ctx, sessionIdContext,
+                                   sizeof(sessionIdContext) - 1);
+    SSL_CTX_set_timeout(ctx, sessionTimeout.count());
+    SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_SERVER |
+                                            SSL_SESS_CACHE_NO_INTERNAL);
+    SSL_CTX_sess_set_new_cb(ctx, &TlsResumption::onNewSession);
+    SSL_CTX_sess_set_get_cb(ctx, &TlsResumption::onGetSession);
+    SSL_CTX_sess_set_remove_cb(ctx, &TlsResumption::onRemoveSession);
+    SSL_CTX_set_tlsext_ticket_key_evp_cb(ctx, &TlsResumption::onTicketKey);
+    SSL_CTX_set_info_callback(ctx, &TlsResumption::onInfo);
+  }
+
+private:
+  struct TicketKey {
+    std::array<unsigned char, 16> name;
+    std::array<unsigned char, 32> aesKey;
+    std::array<unsigned char, 32> hmacKey;
+    Clock::time_point createdAt;
+  };
+
+  struct CachedSession {
+    std::vector<unsigned char> der;
+    Clock::time_point expiresAt;
+  };
+
+  /**
+   * session-ID cache
+   */
+  static int onNewSession(SSL *, SSL_SESSION *session) {
+    unsigned int idLength = 0;
+    auto id = SSL_SESSION_get_id(session, &idLength);
+
+    auto der = std::vector<unsigned char>(i2d_SSL_SESSION(session, nullptr));
+    auto out = der.data();
+    i2d_SSL_SESSION(session, &out);
+
+    instance->store(std::string(reinterpret_cast<const char *>(id), idLength),
+                    std::move(der));
+    // the session is serialized, OpenSSL keeps its own reference
+    return 0;
+  }
+
+  static SSL_SESSION *onGetSession(SSL *, const unsigned char *id, int length,
+                                   int *copy) {
+    *copy = 0;
+    auto der = instance->load(
+        std::string(reinterpret_cast<const char *>(id), length));
+    if (der.empty()) {
+      return nullptr;
+    }
+    const unsigned char *in = der.data();
+    return d2i_SSL_SESSION(nullptr, &in, der.size());
+  }
+
+  static void onRemoveSession(SSL_CTX *, SSL_SESSION *session) {
+    unsigned int idLength = 0;
+    auto id = SSL_SESSION_get_id(session, &idLength);
+    instance->erase(std::string(reinterpret_cast<const char *>(id), idLength));
+  }
+
+  void store(std::string id, std::vector<unsigned char> der) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    auto now = Clock::now();
+    // Every entry lives for the same timeout, so insertion order is also
+    // expiry order
+    while ((order.empty() == false) &&
+           ((sessions.size() >= cacheCapacity) ||
+            (order.front().second <= now))) {
+      auto found = sessions.find(order.front().first);
+      if ((found != sessions.end()) &&
+          (found->second.expiresAt == order.front().second)) {
+        sessions.erase(found);
+      }
+      order.pop_front();
+    }
+    auto expiresAt = now + sessionTimeout;
+    sessions[id] = CachedSession{std::move(der), expiresAt};
+    order.emplace_back(std::move(id), expiresAt);
+    cacheSizeMetric.store(sessions.size(), std::memory_order_relaxed);
+  }
+
+  std::vector<unsigned char> load(const std::string &id) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    auto found = sessions.find(id);
+    if ((found == sessions.end()) ||
+        (found->second.expiresAt <= Clock::now())) {
+      return {};
+    }
+    return found->second.der;
+  }
+
+  void erase(const std::string &id) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    sessions.erase(id);
+    cacheSizeMetric.store(sessions.size(), std::memory_order_relaxed);
+  }
+
+  /**
+   * session ticket
+   * 새 ticket은 항상 최신 key로 암호화
+   * 이전 key로 만든 ticket은 복호화 후 최신 key로 재발급
+   */
+  static int onTicketKey(SSL *, unsigned char *name, unsigned char *iv,
+                         EVP_CIPHER_CTX *cipherCtx, EVP_MAC_CTX *macCtx,
+                         int encrypt) {
+    auto key = TicketKey{};
+    bool newest = false;
+    if (encrypt) {
+      key = instance->currentKey();
+      newest = true;
+      std::copy(key.name.begin(), key.name.end(), name);
+      if (RAND_bytes(iv, EVP_MAX_IV_LENGTH) <= 0) {
+        return -1;
+      }
+      if (EVP_EncryptInit_ex(cipherCtx, EVP_aes_256_cbc(), nullptr,
+                             key.aesKey.data(), iv) <= 0) {
+        return -1;
+      }
+    } else {
+      if (instance->findKey(name, key, newest) == false) {
+        // unknown or retired key : fall back to a full handshake
+        return 0;
+      }
+      if (EVP_DecryptInit_ex(cipherCtx, EVP_aes_256_cbc(), nullptr,
+                             key.aesKey.data(), iv) <= 0) {
+        return -1;
+      }
+    }
+
+    char digest[] = "SHA256";
+    OSSL_PARAM params[] = {
+        OSSL_PARAM_construct_octet_string(
+            OSSL_MAC_PARAM_KEY, key.hmacKey.data(), key.hmacKey.size()),
+        OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, digest, 0),
+        OSSL_PARAM_construct_end()};
+    if (EVP_MAC_CTX_set_params(macCtx, params) <= 0) {
+      return -1;
+    }
+    return newest ? 1 : 2;
+  }
+
+  TicketKey currentKey() {
+    std::lock_guard<std::mutex> lock(keyMutex);
+    auto now = Clock::now();
+    if (keys.empty() || (keys.front().createdAt + keyRotation <= now)) {
+      auto key = TicketKey{};
+      RAND_bytes(key.name.data(), key.name.size());
+      RAND_bytes(key.aesKey.data(), key.aesKey.size());
+      RAND_bytes(key.hmacKey.data(), key.hmacKey.size());
+      key.createdAt = now;
+      keys.push_front(key);
+      // Keep retired keys as long as a ticket made with them may be valid
+      while (keys.back().createdAt + keyRotation + sessionTimeout <= now) {
+        keys.pop_back();
+      }
+      rotatedMetric.fetch_add(1, std::memory_order_relaxed);
+    }
+    return keys.front();
+  }
+
+  bool findKey(const unsigned char *name, TicketKey &key, bool &newest) {
+    std::lock_guard<std::mutex> lock(keyMutex);
+    for (auto iter = keys.begin(); iter != keys.end(); ++iter) {
+      if (std::memcmp(iter->name.data(), name, iter->name.size()) == 0) {
+        key = *iter;
+        newest = (iter == keys.begin()) &&
+                 (iter->createdAt + keyRotation > Clock::now());
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * handshake metrics
+   */
+  static void onInfo(const SSL *ssl, int where, int) {
+    /**
+     * TLS 1.3 also reports post-handshake messages (tickets, key updates) as
+     * handshakes, so the start time is kept until the SSL is freed and only
+     * the first completion is counted
+     */
+    auto startedAt = static_cast<Clock::time_point *>(
+        SSL_get_ex_data(ssl, instance->startIndex));
+    if ((where & SSL_CB_HANDSHAKE_START) && (startedAt == nullptr)) {
+      SSL_set_ex_data(const_cast<SSL *>(ssl), instance->startIndex,
+                      new Clock::time_point(Clock::now()));
+    }
+    if ((where & SSL_CB_HANDSHAKE_DONE) && (startedAt != nullptr) &&
+        (*startedAt != Clock::time_point::min())) {
+      int64_t elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+                            Clock::now() - *startedAt)
+                            .count();
+      *startedAt = Clock::time_point::min();
+
+      if (SSL_session_reused(ssl)) {
+        instance->resumedMetric.fetch_add(1, std::memory_order_relaxed);
+      } else {
+        instance->fullMetric.fetch_add(1, std::memory_order_relaxed);
+      }
+      instance->latencyTotalMetric.fetch_add(elapsed,
+                                             std::memory_order_relaxed);
+      auto latencyMax =
+          instance->latencyMaxMetric.load(std::memory_order_relaxed);
+      while ((latencyMax < elapsed) &&
+             (instance->latencyMaxMetric.compare_exchange_weak(
+                  latencyMax, elapsed) == false)) {
+      }
+    }
+  }
+
+  static void freeStart(void *, void *startedAt, CRYPTO_EX_DATA *, int, long,
+                        void *) {
+    delete static_cast<Clock::time_point *>(startedAt);
+  }
+
+  static std::shared_ptr<TlsResumption> instance;
+  static std::mutex createMutex;
+
+  static constexpr std::chrono::seconds sessionTimeout{3600};
+  static constexpr std::chrono::seconds keyRotation{12 * 3600};
+  static constexpr uint64_t cacheCapacity = 20480;
+
+  int startIndex;
+
+  std::mutex cacheMutex;
+  std::unordered_map<std::string, CachedSession> sessions;
+  std::deque<std::pair<std::string, Clock::time_point>> order;
+
+  std::mutex keyMutex;
+  std::deque<TicketKey> keys;
+
+  Metrics::V &fullMetric;
+  Metrics::V &resumedMetric;
+  Metrics::V &latencyTotalMetric;
+  Metrics::V &latencyMaxMetric;
+  Metrics::V &cacheSizeMetric;
+  Metrics::V &rotatedMetric;
+};
+
+std::shared_ptr<TlsResumption> TlsResumption::instance = nullptr;
+std::mutex TlsResumption::createMutex{};
+
+class TlsCredentials {
+  /**
+   * Certificate chain, private key & DH parameters parsed once
+   * Every new SSL_CTX only takes references to the parsed objects, so
+   * connection setup never reads or parses a PEM file.
+   * reload() parses the files again and swaps the whole set at once; a
+   * failed reload keeps serving the previous set
+   */
+public:
+  static std::shared_ptr<TlsCredentials>
+  getInstance(std::string keyPath, std::string crtPath, std::string dhPath) {
+    std::lock_guard<std::mutex> lock(createMutex);
+    if (instance == nullptr) {
+      instance = std::make_shared<TlsCredentials>(keyPath, crtPath, dhPath);
+    }
+    return instance;
+  }
+  TlsCredentials(std::string keyPath, std::string crtPath, std::string dhPath)
+      : keyPath(keyPath), crtPath(crtPath), dhPath(dhPath),
+        reloadedMetric(
+            Metrics::getInstance()->at("tls.credentials.reloaded")) {
+    current = load();
+  }
+
+  void reload() {
+    auto loaded = load();
+    std::atomic_store(&current, loaded);
+    reloadedMetric.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void apply(SSL_CTX *ctx) {
+    auto bundle = std::atomic_load(&current);
+
+    SSL_CTX_use_certificate(ctx, bundle->certificate.get());
+    for (const auto &certificate : bundle->chain) {
+      SSL_CTX_add1_chain_cert(ctx, certificate.get());
+    }
+    SSL_CTX_use_PrivateKey(ctx, bundle->key.get());
+    // set0 takes ownership of one reference
+    EVP_PKEY_up_ref(bundle->dh.get());
+    if (SSL_CTX_set0_tmp_dh_pkey(ctx, bundle->dh.get()) == 0) {
+      EVP_PKEY_free(bundle->dh.get());
+    }
+  }
+
+private:
+  struct Bundle {
+    std::unique_ptr<X509, decltype(&X509_free)> certificate{nullptr,
+                                                            &X509_free};
+    std::vector<std::unique_ptr<X509, decltype(&X509_free)>> chain;
+    std::unique_ptr<EVP_PKEY, decltype(&EVP_PKEY_free)> key{nullptr,
+                                                            &EVP_PKEY_free};
+    std::unique_ptr<EVP_PKEY, decltype(&EVP_PKEY_free)> dh{nullptr,
+                                                           &EVP_PKEY_free};
+  };
+
+  using BIO_PTR = std::unique_ptr<BIO, decltype(&BIO_free)>;
+
+  static BIO_PTR open(const std::string &path) {
+    auto bio = BIO_PTR(BIO_new_file(path.c_str(), "r"), &BIO_free);
+    if (bio == nullptr) {
+      throw SecurityException(fmt::v9::format("cannot open {}", path));
+    }
+    return bio;
+  }
+
+  std::shared_ptr<const Bundle> load() {
+    auto bundle = std::make_shared<Bundle>();
+
+    auto crt = open(crtPath);
+    bundle->certificate.reset(
+        PEM_read_bio_X509(crt.get(), nullptr, nullptr, nullptr));
+    if (bundle->certificate == nullptr) {
+      throw SecurityException(
+          fmt::v9::format("cannot parse certificate {}", crtPath));
+    }
+    while (auto certificate =
+               PEM_read_bio_X509(crt.get(), nullptr, nullptr, nullptr)) {
+      bundle->chain.emplace_back(certificate, &X509_free);
+    }
+
+    auto key = open(keyPath);
+    bundle->key.reset(
+        PEM_read_bio_PrivateKey(key.get(), nullptr, nullptr, nullptr));
+    if ((bundle->key == nullptr) ||
+        (X509_check_private_key(bundle->certificate.get(),
+                                bundle->key.get()) != 1)) {
+      throw SecurityException(
+          fmt::v9::format("private key {} does not match {}", keyPath,
+                          crtPath));
+    }
+
+    auto dh = open(dhPath);
+    bundle->dh.reset(PEM_read_bio_Parameters(dh.get(), nullptr));
+    if (bundle->dh == nullptr) {
+      throw SecurityException(
+          fmt::v9::format("cannot parse dh parameters {}", dhPath));
+    }
+    return bundle;
+  }
+
+  static std::shared_ptr<TlsCredentials> instance;
+  static std::mutex createMutex;
+
+  std::string keyPath;
+  std::string crtPath;
+  std::string dhPath;
+  std::shared_ptr<const Bundle> current;
+
+  Metrics::V &reloadedMetric;
+
+  TlsCredentials() = delete;
+};
+
+std::shared_ptr<TlsCredentials> TlsCredentials::instance = nullptr;
+std::mutex TlsCredentials::createMutex{};
+} // namespace chat::module
@@ -0,0 +1,158 @@
+#pragma once
+
+#include "exception.hpp"
+using namespace chat::module::exception;
+
+#include <fmt/core.h>
+
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <openssl/rand.h>
+
+#include <array>
+#include <charconv>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace chat::module {
+
+class TokenSigner {
+  /**
+   * Self-contained session tokens
+   *  v1.<type>.<principal id>.<session id>.<expiredAt>.<HMAC-SHA256 hex>
+   * Every node configured with the same secret verifies a token by itself;
+   * no session state has to be shared. Without a secret a random key is
+   * drawn, and tokens are then valid on this process only
+   */
+public:
+  enum class TYPE : char { COMPANY = 'c', USER = 'u' };
+
+  struct Claims {
+    TYPE type;
+    uint64_t principalId;
+    uint64_t sessionId;
+    time_t expiredAt;
+  };
+
+  static std::shared_ptr<TokenSigner> getInstance(std::string secret = "") {
+    // the secret of the first call is kept
+    std::lock_guard<std::mutex> lock(createMutex);
+    if (instance == nullptr) {
+      instance = std::make_shared<TokenSigner>(secret);
+    }
+    return instance;
+  }
+
+  TokenSigner(std::string secret) : key(secret.begin(), secret.end()) {
+    if (key.empty()) {
+      key.resize(keyLength);
+      if (RAND_bytes(key.data(), key.size()) != 1) {
+        throw BusinessException(fmt::v9::format("TokenSigner : no entropy"));
+      }
+    }
+  }
+
+  std::string sign(const Claims &claims) const {
+    auto payload = fmt::v9::format("{}.{}.{}.{}.{}", version,
+                                   static_cast<char>(claims.type),
+                                   claims.principalId, claims.sessionId,
+                                   claims.expiredAt);
+    return fmt::v9::format("{}.{}", payload, toHex(macOf(payload)));
+  }
+
+  std::optional<Claims> verify(std::string_view token) const {
+    /**
+     * Claims of a well-formed token with a valid MAC, expired or not
+     */
+    auto dot = token.rfind('.');
+    if ((dot == std::string_view::npos) ||
+        (token.size() - dot - 1 != macLength * 2)) {
+      return std::nullopt;
+    }
+    auto payload = token.substr(0, dot);
+    auto expected = toHex(macOf(payload));
+    if (CRYPTO_memcmp(expected.data(), token.data() + dot + 1,
+                      expected.size()) != 0) {
+      return std::nullopt;
+    }
+
+    // v1.<type>.<principal id>.<session id>.<expiredAt>
+    auto fields = std::vector<std::string_view>{};
+    size_t begin = 0;
+    while (begin <= payload.size()) {
+      auto end = payload.find('.', begin);
+      if (end == std::string_view::npos) {
+        end = payload.size();
+      }
+      fields.emplace_back(payload.substr(begin, end - begin));
+      begin = end + 1;
+    }
+    if ((fields.size() != 5) || (fields[0] != version) ||
+        (fields[1].size() != 1)) {
+      return std::nullopt;
+    }
+
+    auto claims = Claims{};
+    auto type = static_cast<TYPE>(fields[1].front());
+    if ((type != TYPE::COMPANY) && (type != TYPE::USER)) {
+      return std::nullopt;
+    }
+    claims.type = type;
+    if ((parse(fields[2], claims.principalId) == false) ||
+        (parse(fields[3], claims.sessionId) == false) ||
+        (parse(fields[4], claims.expiredAt) == false)) {
+      return std::nullopt;
+    }
+    return claims;
+  }
+
+private:
+  static constexpr std::string_view version = "v1";
+  static constexpr size_t keyLength = 32;
+  static constexpr size_t macLength = 32;
+
+  using MAC = std::array<unsigned char, macLength>;
+
+  MAC macOf(std::string_view payload) const {
+    auto mac = MAC{};
+    unsigned int length = 0;
+    HMAC(EVP_sha256(), key.data(), key.size(),
+         reinterpret_cast<const unsigned char *>(payload.data()),
+         payload.size(), mac.data(), &length);
+    return mac;
+  }
+
+  static std::string toHex(const MAC &mac) {
+    static constexpr char digits[] = "0123456789abcdef";
+    auto hex = std::string(mac.size() * 2, '0');
+    for (size_t i = 0; i < mac.size(); ++i) {
+      hex[i * 2] = digits[mac[i] >> 4];
+      hex[i * 2 + 1] = digits[mac[i] & 0x0f];
+    }
+    return hex;
+  }
+
+  template <typename T> static bool parse(std::string_view field, T &value) {
+    auto [end, error] =
+        std::from_chars(field.data(), field.data() + field.size(), value);
+    return (error == std::errc{}) && (end == field.data() + field.size());
+  }
+
+  static std::shared_ptr<TokenSigner> instance;
+  static std::mutex createMutex;
+
+  std::vector<unsigned char> key;
+
+  TokenSigner() = delete;
+};
+
+std::shared_ptr<TokenSigner> TokenSigner::instance = nullptr;
+std::mutex TokenSigner::createMutex{};
+} // namespace chat::module
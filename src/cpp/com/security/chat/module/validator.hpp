@@ -0,0 +1,103 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+namespace chat::module::validator {
+/**
+ * Input validators over compile-time character-class tables
+ * Nothing is built per call and nothing is allocated: one table lookup per
+ * byte, and a small DFA for the e-mail grammar.
+ * The classes are those of the "C" locale, the one this server runs in,
+ * so bytes >= 0x80 never belong to a class
+ */
+
+enum CLASS : uint8_t { ALNUM = 1 << 0, WORD = 1 << 1 };
+
+constexpr std::array<uint8_t, 256> classes = [] {
+  auto table = std::array<uint8_t, 256>{};
+  for (int c = '0'; c <= '9'; ++c) {
+    table[c] = ALNUM | WORD;
+  }
+  for (int c = 'a'; c <= 'z'; ++c) {
+    table[c] = ALNUM | WORD;
+    table[c - 'a' + 'A'] = ALNUM | WORD;
+  }
+  table['_'] = WORD;
+  return table;
+}();
+
+constexpr bool is(unsigned char c, CLASS klass) {
+  return (classes[c] & klass) != 0;
+}
+
+// [A-Za-z0-9]*, the empty string included
+constexpr bool isAlnum(std::string_view input) {
+  for (unsigned char c : input) {
+    if (!is(c, ALNUM)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+constexpr bool isEmail(std::string_view email) {
+  /**
+   * The language of the former std::regex
+   *   (\w+)(\.|_)?(\w*)@(\w+)(\.(\w+))+
+   * '_' is a word character, so the local part is \w+ with at most one
+   * '.' after its first character, and the domain is two or more non-empty
+   * \w+ labels joined by '.'
+   */
+  enum STATE : uint8_t {
+    START,
+    LOCAL,
+    LOCAL_DOT,
+    AT,
+    LABEL,
+    DOT,
+    DOMAIN,
+    REJECT
+  };
+
+  auto state = START;
+  for (unsigned char c : email) {
+    bool word = is(c, WORD);
+    switch (state) {
+    case START:
+      state = word ? LOCAL : REJECT;
+      break;
+    case LOCAL:
+      state = word ? LOCAL : (c == '.') ? LOCAL_DOT : (c == '@') ? AT : REJECT;
+      break;
+    case LOCAL_DOT:
+      state = word ? LOCAL_DOT : (c == '@') ? AT : REJECT;
+      break;
+    case AT:
+      state = word ? LABEL : REJECT;
+      break;
+    case LABEL:
+      state = word ? LABEL : (c == '.') ? DOT : REJECT;
+      break;
+    case DOT:
+      state = word ? DOMAIN : REJECT;
+      break;
+    case DOMAIN:
+      state = word ? DOMAIN : (c == '.') ? DOT : REJECT;
+      break;
+    case REJECT:
+      return false;
+    }
+  }
+  return state == DOMAIN;
+}
+
+static_assert(isAlnum("") && isAlnum("Room42") && !isAlnum("a b") &&
+              !isAlnum("x'--"));
+static_assert(isEmail("a@b.c") && isEmail("first.last@mail.co.kr") &&
+              isEmail("a_b@c.d") && isEmail("a.@b.c"));
+static_assert(!isEmail("@b.c") && !isEmail("a@b") && !isEmail("a@b.") &&
+              !isEmail("a..b@c.d") && !isEmail(".a@b.c") &&
+              !isEmail("a@b..c") && !isEmail("a@@b.c"));
+} // namespace chat::module::validator
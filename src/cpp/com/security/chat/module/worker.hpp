@@ -0,0 +1,257 @@
+#pragma once
+
+#include "metrics.hpp"
+
+#include <fmt/core.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace chat::module {
+
+class WorkerPool : public std::enable_shared_from_this<WorkerPool> {
+  /**
+   * Fixed number of threads draining one FIFO
+   * Idle workers sleep on the condition variable.
+   * The FIFO is fed by Lanes, plus coroutines of admitted jobs resuming
+   * (module/coroutine.hpp), so its depth stays around the sum of the lane
+   * concurrency limits
+   */
+public:
+  using Job = std::function<void()>;
+
+  static std::weak_ptr<WorkerPool> current() {
+    // the pool running the calling thread, empty outside of any pool
+    if (running == nullptr) {
+      return {};
+    }
+    return running->weak_from_this();
+  }
+
+  WorkerPool(std::string name, uint64_t workers)
+      : stopped(false),
+        queueDepth(Metrics::getInstance()->at(
+            fmt::v9::format("pool.{}.queue_depth", name))) {
+    Metrics::getInstance()->set(fmt::v9::format("pool.{}.workers", name),
+                                workers);
+    for (uint64_t i = 0; i < workers; ++i) {
+      threads.emplace_back(&WorkerPool::run, this);
+    }
+  }
+
+  ~WorkerPool() { stop(); }
+
+  bool submit(Job job) {
+    {
+      std::lock_guard<std::mutex> lock(queueMutex);
+      if (stopped) {
+        return false;
+      }
+      queue.emplace_back(std::move(job));
+      queueDepth.store(queue.size(), std::memory_order_relaxed);
+    }
+    queueCond.notify_one();
+    return true;
+  }
+
+  void stop() {
+    {
+      std::lock_guard<std::mutex> lock(queueMutex);
+      if (stopped) {
+        return;
+      }
+      stopped = true;
+    }
+    queueCond.notify_all();
+    for (auto &thread : threads) {
+      if (thread.joinable()) {
+        thread.join();
+      }
+    }
+  }
+
+private:
+  void run() {
+    running = this;
+    while (true) {
+      auto job = Job{};
+      {
+        std::unique_lock<std::mutex> lock(queueMutex);
+        queueCond.wait(lock, [this]() { return stopped || !queue.empty(); });
+        if (queue.empty()) {
+          // stopped & drained
+          return;
+        }
+        job = std::move(queue.front());
+        queue.pop_front();
+        queueDepth.store(queue.size(), std::memory_order_relaxed);
+      }
+      job();
+    }
+  }
+
+  static thread_local WorkerPool *running;
+
+  bool stopped;
+  Metrics::V &queueDepth;
+
+  std::mutex queueMutex;
+  std::condition_variable queueCond;
+  std::deque<Job> queue;
+  std::vector<std::thread> threads;
+
+  WorkerPool() = delete;
+};
+
+thread_local WorkerPool *WorkerPool::running = nullptr;
+
+class Lane {
+  /**
+   * Per-route admission in front of the shared pool
+   * At most `concurrency` jobs of this lane run at once; the overflow waits
+   * here (up to `capacity`) instead of occupying pool workers, so a slow
+   * route cannot starve the others. Beyond that, submit() refuses the job
+   *
+   * A job holds its slot until it calls `done` exactly once, which may be
+   * after it has returned (e.g. from the continuation of an async handler)
+   *
+   * Once the pool has stopped, an admitted job can no longer start : its
+   * `reject` runs instead and the slot is released
+   */
+public:
+  using Done = std::function<void()>;
+  using Job = std::function<void(Done)>;
+  using Reject = std::function<void()>;
+  using Clock = std::chrono::steady_clock;
+
+  Lane(std::string name, std::shared_ptr<WorkerPool> pool,
+       uint64_t concurrency, uint64_t capacity)
+      : pool(pool), concurrency(concurrency), capacity(capacity), inFlight(0),
+        inFlightMetric(metricOf(name, "in_flight")),
+        queueDepthMetric(metricOf(name, "queue_depth")),
+        startedMetric(metricOf(name, "started")),
+        rejectedMetric(metricOf(name, "rejected")),
+        waitTotalMetric(metricOf(name, "wait_us_total")),
+        waitMaxMetric(metricOf(name, "wait_us_max")) {
+    metricOf(name, "concurrency").store(concurrency);
+    metricOf(name, "capacity").store(capacity);
+  }
+
+  bool submit(Job job, Reject reject = []() {}) {
+    /**
+     * return : false if the lane is full. A job admitted here either runs,
+     *          or has its reject called if the pool has stopped
+     */
+    {
+      std::lock_guard<std::mutex> lock(laneMutex);
+      if (inFlight < concurrency) {
+        ++inFlight;
+        if (start(Waiting{std::move(job), reject, Clock::now()})) {
+          publish();
+          return true;
+        }
+        --inFlight;
+        publish();
+      } else if (waiting.size() < capacity) {
+        waiting.push_back(Waiting{std::move(job), reject, Clock::now()});
+        publish();
+        return true;
+      } else {
+        rejectedMetric.fetch_add(1, std::memory_order_relaxed);
+        return false;
+      }
+    }
+    rejectedMetric.fetch_add(1, std::memory_order_relaxed);
+    reject();
+    return true;
+  }
+
+private:
+  static Metrics::V &metricOf(const std::string &name,
+                              const std::string &field) {
+    return Metrics::getInstance()->at(
+        fmt::v9::format("route.{}.{}", name, field));
+  }
+
+  struct Waiting {
+    Job job;
+    Reject reject;
+    Clock::time_point enqueuedAt;
+  };
+
+  bool start(Waiting next) {
+    // under laneMutex; false if the pool has stopped
+    return pool->submit([this, job = std::move(next.job),
+                         enqueuedAt = next.enqueuedAt]() {
+      int64_t waited = std::chrono::duration_cast<std::chrono::microseconds>(
+                           Clock::now() - enqueuedAt)
+                           .count();
+      startedMetric.fetch_add(1, std::memory_order_relaxed);
+      waitTotalMetric.fetch_add(waited, std::memory_order_relaxed);
+      auto waitMax = waitMaxMetric.load(std::memory_order_relaxed);
+      while ((waitMax < waited) && (waitMaxMetric.compare_exchange_weak(
+                                        waitMax, waited) == false)) {
+      }
+
+      job([this]() { finish(); });
+    });
+  }
+
+  void finish() {
+    auto rejected = std::vector<Reject>{};
+    {
+      std::lock_guard<std::mutex> lock(laneMutex);
+      while (true) {
+        if (waiting.empty()) {
+          --inFlight;
+          break;
+        }
+        // hand the slot over to the oldest waiting job
+        auto next = std::move(waiting.front());
+        waiting.pop_front();
+        auto reject = next.reject;
+        if (start(std::move(next))) {
+          break;
+        }
+        rejected.emplace_back(std::move(reject));
+      }
+      publish();
+    }
+    rejectedMetric.fetch_add(rejected.size(), std::memory_order_relaxed);
+    for (auto &reject : rejected) {
+      reject();
+    }
+  }
+
+  void publish() {
+    inFlightMetric.store(inFlight, std::memory_order_relaxed);
+    queueDepthMetric.store(waiting.size(), std::memory_order_relaxed);
+  }
+
+  std::shared_ptr<WorkerPool> pool;
+  uint64_t concurrency;
+  uint64_t capacity;
+  uint64_t inFlight;
+
+  Metrics::V &inFlightMetric;
+  Metrics::V &queueDepthMetric;
+  Metrics::V &startedMetric;
+  Metrics::V &rejectedMetric;
+  Metrics::V &waitTotalMetric;
+  Metrics::V &waitMaxMetric;
+
+  std::mutex laneMutex;
+  std::deque<Waiting> waiting;
+
+  Lane() = delete;
+};
+} // namespace chat::module
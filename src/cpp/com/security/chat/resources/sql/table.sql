@@ -1,3 +1,4 @@
+DROP TABLE IF EXISTS outbox_mail;
 DROP TABLE IF EXISTS room_participant;
 DROP TABLE IF EXISTS invitation;
 DROP TABLE IF EXISTS chat_room;
@@ -46,7 +47,8 @@ CREATE TABLE `chat_password` (
 	`created_at`	DATETIME	NOT NULL	DEFAULT NOW(),
 	`last_modified_at`	DATETIME	NOT NULL	DEFAULT NOW(),
 	`salt`	TEXT	NOT NULL,
-	`hashed_pw`	TEXT	NOT NULL
+	`hashed_pw`	TEXT	NOT NULL,
+	`cost`	INT UNSIGNED	NOT NULL	DEFAULT 0
 );
 
 CREATE TABLE `invitation` (
@@ -59,6 +61,17 @@ CREATE TABLE `invitation` (
 	`password`	TEXT	NOT NULL	COMMENT '난수로 생성된 일회용 비밀번호'
 );
 
+CREATE TABLE `outbox_mail` (
+	`mail_id`	INT	NOT NULL ,
+	`created_at`	DATETIME	NOT NULL	DEFAULT NOW(),
+	`last_modified_at`	DATETIME	NOT NULL	DEFAULT NOW(),
+	`recipient`	VARCHAR(500)	NOT NULL,
+	`subject`	TEXT	NOT NULL,
+	`body`	TEXT	NOT NULL,
+	`attempts`	INT UNSIGNED	NOT NULL	DEFAULT 0,
+	`next_at`	DATETIME	NOT NULL	DEFAULT NOW()	COMMENT '이 시각 이후에 (다시) 보낸다'
+);
+
 ALTER TABLE `company` ADD CONSTRAINT `PK_COMPANY` PRIMARY KEY (
 	`company_id`
 );
@@ -88,12 +101,17 @@ ALTER TABLE `invitation` ADD CONSTRAINT `PK_INVITATION` PRIMARY KEY (
 	`user_id`
 );
 
+ALTER TABLE `outbox_mail` ADD CONSTRAINT `PK_OUTBOX_MAIL` PRIMARY KEY (
+	`mail_id`
+);
+
 ALTER TABLE company MODIFY company_id INT NOT NULL AUTO_INCREMENT;
 ALTER TABLE chat_user MODIFY user_id INT NOT NULL AUTO_INCREMENT;
 ALTER TABLE chat_room MODIFY room_id INT NOT NULL AUTO_INCREMENT;
 ALTER TABLE room_participant MODIFY participant_id INT NOT NULL AUTO_INCREMENT;
 ALTER TABLE chat_password MODIFY pw_id INT NOT NULL AUTO_INCREMENT;
 ALTER TABLE invitation MODIFY invitation_id INT NOT NULL AUTO_INCREMENT;
+ALTER TABLE outbox_mail MODIFY mail_id INT NOT NULL AUTO_INCREMENT;
 
 ALTER TABLE `chat_user` ADD CONSTRAINT `FK_company_TO_chat_user_1` FOREIGN KEY (
 	`company_id`
@@ -144,5 +162,19 @@ REFERENCES `chat_user` (
 	`user_id`
 );
 
+CREATE INDEX `IDX_CHAT_USER_COMPANY` ON `chat_user` (
+	`company_id`,
+	`user_id`
+);
+
+CREATE INDEX `IDX_ROOM_PARTICIPANT_ROOM` ON `room_participant` (
+	`room_id`,
+	`participant_id`
+);
+
+CREATE INDEX `IDX_OUTBOX_MAIL_NEXT` ON `outbox_mail` (
+	`next_at`
+);
+
 INSERT INTO company(name) VALUES ('company');
 INSERT INTO chat_password(company_id, salt, hashed_pw) VALUES(1, 'd7C4D5VNDBMyeNjQtLWKU8kTadIc16cV8P3s2iUSceJWGsb286hULftdS7NpW7vunpAhAhnn2IuYWyb2BviF7xRTYLyLe1VAlGJe', '1776824189');
@@ -1,17 +1,20 @@
 #pragma once
 
 #include "../dao/company/entity.hpp"
+#include "../dao/participant/role_cache.hpp"
 #include "../dao/password/entity.hpp"
 #include "../dao/server_session/entity.hpp"
 #include "../dao/server_session/memory_repository.hpp"
 #include "../dao/user/entity.hpp"
 
 #include "../module/all.hpp"
+#include "../module/token.hpp"
 using namespace chat::module::exception;
 
 #include "base.hpp"
 #include "company.hpp"
 #include "password.hpp"
+#include "reaper.hpp"
 #include "room.hpp"
 #include "user.hpp"
 
@@ -19,6 +22,8 @@ using namespace chat::module::exception;
 
 #include <fmt/core.h>
 
+#include <pplx/pplxtasks.h>
+
 #include <cstdlib>
 #include <ctime>
 #include <exception>
@@ -26,6 +31,7 @@ using namespace chat::module::exception;
 #include <mutex>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace chat::service {
 
@@ -38,7 +44,7 @@ public:
     }
     return instance;
   }
-  AuthService(L serverLogger, CN conn, uint64_t tokenLength = 512)
+  AuthService(L serverLogger, CN conn)
       : BaseService(serverLogger, conn),
         serverSessionRepository(
             dao::ServerSessionRepository::getInstance(serverLogger)),
@@ -46,112 +52,36 @@ public:
         companyService(CompanyService::getInstance(serverLogger, conn)),
         passwordService(PasswordService::getInstance(serverLogger, conn)),
         roomService(RoomService::getInstance(serverLogger, conn)),
-        tokenLength(tokenLength) {}
-
-  R getSession(uint64_t sessionId) {
-    auto session = std::unique_ptr<mysqlx::Session>(nullptr);
-    try {
-      session = std::make_unique<mysqlx::Session>(conn->client->getSession());
-      session->startTransaction();
+        sessionReaper(SessionReaper::getInstance(serverLogger)),
+        tokenSigner(module::TokenSigner::getInstance()),
+        loginGuard(module::LoginGuard::getInstance()) {}
 
-      auto serverSession =
-          removeIfExpired(*session, sessionId)
-              ? nullptr
-              : serverSessionRepository->findById(*session, sessionId);
-      if (serverSession != nullptr) {
-        session->commit();
-        return serverSession;
-      } else {
-        throw NotFoundEntityException(fmt::v9::format(
-            "AuthService : id={} not in ServerSession", sessionId));
-      }
-    } catch (const NotFoundEntityException &e) {
-      if (session != nullptr) {
-        session->rollback();
-      }
-      serverLogger->error(e.what());
-      throw;
-    } catch (const std::exception &e) {
-      if (session != nullptr) {
-        session->rollback();
-      }
-      auto msg = fmt::v9::format("AutoService : {}", e.what());
-      serverLogger->error(msg);
-      throw ServiceException(msg);
+  E authenticate(uint64_t sessionId, const std::string &token) {
+    /**
+     * session id & token -> principal(Company or User)
+     * token의 서명과 만료만 확인하므로 어느 node에서 발급했든 검증된다.
+     * principal은 이 process의 cache에서 찾고, 처음 보는 session이면 DB에서
+     * 한 번 읽어 cache한다. logout된 session은 token이 만료될 때까지 거부
+     * 서명이 틀렸거나, 만료됐거나, logout됐으면 nullptr
+     */
+    auto claims = tokenSigner->verify(token);
+    if ((claims.has_value() == false) || (claims->sessionId != sessionId) ||
+        (claims->expiredAt < module::getCurrentTime())) {
+      return nullptr;
     }
-  }
 
-  bool verifyToken(uint64_t sessionId, std::string token) {
-    auto session = std::unique_ptr<mysqlx::Session>(nullptr);
-    try {
-      session = std::make_unique<mysqlx::Session>(conn->client->getSession());
-      session->startTransaction();
-
-      auto serverSession =
-          removeIfExpired(*session, sessionId)
-              ? nullptr
-              : std::dynamic_pointer_cast<dao::ServerSession>(
-                    serverSessionRepository->findById(*session, sessionId));
-      if (serverSession == nullptr) {
-        throw NotFoundEntityException(fmt::v9::format(
-            "AuthService : id={} not in ServerSession", sessionId));
-      }
-      auto storedToken = serverSession->getToken();
-      session->commit();
-
-      if (token == storedToken) {
-        return true;
-      } else {
-        return false;
+    auto serverSession = serverSessionRepository->find(sessionId);
+    // 재시작 후 복원된 session은 principal의 key와 만료 시각만 가지고 있다
+    if ((serverSession == nullptr) || (serverSession->getValue() == nullptr)) {
+      if (serverSessionRepository->isRevoked(sessionId)) {
+        return nullptr;
       }
-    } catch (const NotFoundEntityException &e) {
-      if (session != nullptr) {
-        session->rollback();
-      }
-      serverLogger->error(e.what());
-      throw;
-    } catch (const std::exception &e) {
-      if (session != nullptr) {
-        session->rollback();
-      }
-      auto msg = fmt::v9::format("AutoService : {}", e.what());
-      serverLogger->error(msg);
-      throw ServiceException(msg);
-    }
-  }
-
-  bool removeIfExpired(mysqlx::Session &session, uint64_t sessionId) {
-    try {
-      auto serverSession =
-          serverSessionRepository->findById(session, sessionId);
-      if (serverSession != nullptr) {
-        if (std::dynamic_pointer_cast<dao::ServerSession>(serverSession)
-                ->getExpiredAt() < module::getCurrentTime()) {
-          if (serverSessionRepository->remove(session, serverSession)) {
-            return true;
-          } else {
-            throw NotRemovedEntityException(fmt::v9::format(
-                "AuthService : id={} cannot be removed", sessionId));
-          }
-        } else {
-          // expired > current : Don't expire session!
-          return false;
-        }
-      } else {
-        throw NotFoundEntityException(fmt::v9::format(
-            "AuthService : id={} not in ServerSession", sessionId));
+      serverSession = adopt(*claims);
+      if (serverSession == nullptr) {
+        return nullptr;
       }
-    } catch (const NotRemovedEntityException &e) {
-      serverLogger->error(e.what());
-      throw;
-    } catch (const NotFoundEntityException &e) {
-      serverLogger->error(e.what());
-      throw;
-    } catch (const std::exception &e) {
-      auto msg = fmt::v9::format("AuthService : {}", e.what());
-      serverLogger->error(msg);
-      throw ServiceException(msg);
     }
+    return serverSession->getValue();
   }
 
   bool isCompany(E entity) {
@@ -165,9 +95,8 @@ public:
   bool isHost(E entity, uint64_t roomId) {
     try {
       if (isUser(entity)) {
-        auto host = roomService->findHost(roomId);
-        return std::dynamic_pointer_cast<dao::Participant>(host)->getUserId() ==
-               entity->getId();
+        return roleOf(std::dynamic_pointer_cast<dao::User>(entity), roomId) ==
+               dao::Participant::TYPE::HOST;
       } else {
         return false;
       }
@@ -186,127 +115,219 @@ public:
     }
   }
 
-  R loginOfCompany(std::string name, std::string pw) {
+  pplx::task<R> loginOfCompany(std::string name, std::string pw,
+                               std::string address) {
     /**
      * Multiple sessions of one entity are permitted
+     * The password is compared on the hashing pool; the session is opened
+     * in the continuation, so no thread waits for the hash.
+     * A locked name or address is refused before the lookup, an unknown
+     * name after a hash as costly as a known one
      */
-    constexpr time_t timeOffset = 1800l; // 1800secs
-
-    auto session = std::unique_ptr<mysqlx::Session>(nullptr);
     try {
-      session = std::make_unique<mysqlx::Session>(conn->client->getSession());
-      session->startTransaction();
-
-      auto company = companyService->findByName(name);
-      if (passwordService->compareWithCompanyPw(company->getId(), pw)) {
-        auto token = module::secure::generateFixedLengthCode(tokenLength);
-        auto expiredAt =
-            static_cast<time_t>(module::getCurrentTime() + timeOffset);
-        R serverSession = std::make_shared<dao::ServerSession>(
-            company, token, module::convertToLocalTimeTM(expiredAt));
-        serverSession = serverSessionRepository->save(*session, serverSession);
-
-        if (serverSession != nullptr) {
-          session->commit();
-          return serverSession;
-        } else {
-          throw NotSavedEntityException(fmt::v9::format(
-              "AuthService: company(name={}) cannot login", name));
-        }
-      } else {
-        throw NotSavedEntityException(fmt::v9::format(
-            "AuthService: company(name={}) has different password", name));
-      }
-    } catch (const NotSavedEntityException &e) {
-      if (session != nullptr) {
-        session->rollback();
+      auto account = fmt::v9::format("company {}", name);
+      address = fmt::v9::format("address {}", address);
+      admit(account, address);
+
+      auto company = R{nullptr};
+      try {
+        company = companyService->findByName(name);
+      } catch (const NotFoundEntityException &e) {
+        loginGuard->fail(account, address);
+        return refuse(pw, e.what());
       }
-      serverLogger->error(e.what());
+      return passwordService->compareWithCompanyPw(company->getId(), pw)
+          .then([this, company, name, account, address](bool matched) {
+            settle(account, address, matched);
+            return openSession(company, matched,
+                               fmt::v9::format("company(name={})", name));
+          });
+    } catch (const OverloadedException &e) {
       throw;
     } catch (const std::exception &e) {
-      if (session != nullptr) {
-        session->rollback();
-      }
       auto msg = fmt::v9::format("AutoService : {}", e.what());
       serverLogger->error(msg);
       throw ServiceException(msg);
     }
   }
 
-  R loginOfUser(std::string email, std::string pw) {
+  pplx::task<R> loginOfUser(std::string email, std::string pw,
+                            std::string address) {
     /**
      * Multiple sessions of one entity are permitted
+     * The password is compared on the hashing pool; the session is opened
+     * in the continuation, so no thread waits for the hash.
+     * A locked email or address is refused before the lookup, an unknown
+     * email after a hash as costly as a known one
      */
-    constexpr time_t timeOffset = 1800l;
-
-    auto session = std::unique_ptr<mysqlx::Session>(nullptr);
     try {
-      session = std::make_unique<mysqlx::Session>(conn->client->getSession());
-      session->startTransaction();
+      auto account = fmt::v9::format("user {}", email);
+      address = fmt::v9::format("address {}", address);
+      admit(account, address);
+
+      auto user = R{nullptr};
+      try {
+        user = userService->findByEmail(email);
+      } catch (const NotFoundEntityException &e) {
+        loginGuard->fail(account, address);
+        return refuse(pw, e.what());
+      }
+      return passwordService->compareWithUserPw(user->getId(), pw)
+          .then([this, user, email, account, address](bool matched) {
+            settle(account, address, matched);
+            std::dynamic_pointer_cast<dao::User>(user)->setRoles(
+                std::make_shared<dao::RoleCache>());
+            return openSession(user, matched,
+                               fmt::v9::format("user(email={})", email));
+          });
+    } catch (const OverloadedException &e) {
+      throw;
+    } catch (const std::exception &e) {
+      auto msg = fmt::v9::format("AutoService : {}", e.what());
+      serverLogger->error(msg);
+      throw ServiceException(msg);
+    }
+  }
 
-      auto user = userService->findByEmail(email);
-      if (passwordService->compareWithUserPw(user->getId(), pw)) {
-        auto token = module::secure::generateFixedLengthCode(tokenLength);
-        auto expiredAt =
-            static_cast<time_t>(module::getCurrentTime() + timeOffset);
+  R refresh(uint64_t sessionId, const std::string &token) {
+    /**
+     * 유효한 token으로 같은 session을 sessionLifetime만큼 연장, token 재발급
+     * 메모리 작업만 한다 : 이메일 조회, password 비교 없음
+     * 이전 token은 원래 만료 시각까지 유효하다.
+     * reaper에 등록된 이전 만료는 그 시각에 새 expiredAt으로 다시 등록된다
+     */
+    auto principal = authenticate(sessionId, token);
+    if (principal == nullptr) {
+      throw NotAuthorizedException(fmt::v9::format(
+          "AuthService : id={} cannot be refreshed", sessionId));
+    }
 
-        R serverSession = std::make_shared<dao::ServerSession>(
-            user, token, module::convertToLocalTimeTM(expiredAt));
-        serverSession = serverSessionRepository->save(*session, serverSession);
-        if (serverSession != nullptr) {
-          session->commit();
-          return serverSession;
-        } else {
-          throw NotSavedEntityException(fmt::v9::format(
-              "AuthService: user(email={}) cannot login", email));
-        }
+    auto expiredAt =
+        static_cast<time_t>(module::getCurrentTime() + sessionLifetime);
+    auto serverSession = serverSessionRepository->renew(
+        std::make_shared<dao::ServerSession>(principal, expiredAt, sessionId));
+    if (serverSession == nullptr) {
+      throw NotAuthorizedException(fmt::v9::format(
+          "AuthService : id={} logged out while refreshing", sessionId));
+    }
+    return serverSession;
+  }
+
+  std::vector<std::shared_ptr<dao::ServerSession>>
+  findAllSessionsOf(E principal) {
+    // 이 process에 있는 principal의 session들
+    return serverSessionRepository->findAllOf(
+        dao::ServerSession::Principal::of(principal));
+  }
+
+  uint64_t logoutEverywhere(E principal) {
+    /**
+     * principal의 모든 session을 revoke, 요청한 session 포함
+     * 이 process에 있는 session만 대상이다
+     */
+    return serverSessionRepository->revokeAllOf(
+        dao::ServerSession::Principal::of(principal));
+  }
+
+  bool logout(uint64_t sessionId) {
+    /**
+     * token은 만료될 때까지 유효하므로 삭제 대신 revoke
+     * revoke는 이 process에만 기록된다
+     */
+    try {
+      auto serverSession = serverSessionRepository->find(sessionId);
+      if (serverSession != nullptr) {
+        serverSessionRepository->revoke(sessionId,
+                                        serverSession->getExpiredAt());
+        return true;
       } else {
-        throw NotSavedEntityException(fmt::v9::format(
-            "AuthService: user(email={}) has different password", email));
-      }
-    } catch (const NotSavedEntityException &e) {
-      if (session != nullptr) {
-        session->rollback();
+        throw NotFoundEntityException(fmt::v9::format(
+            "AuthService : id={} not in serverSession", sessionId));
       }
+    } catch (const NotFoundEntityException &e) {
       serverLogger->error(e.what());
       throw;
     } catch (const std::exception &e) {
-      if (session != nullptr) {
-        session->rollback();
-      }
       auto msg = fmt::v9::format("AutoService : {}", e.what());
       serverLogger->error(msg);
       throw ServiceException(msg);
     }
   }
 
-  bool logout(uint64_t sessionId) {
+private:
+  static std::shared_ptr<AuthService> instance;
+  static std::mutex createMutex;
+
+  std::shared_ptr<dao::ServerSessionRepository> serverSessionRepository;
+  std::shared_ptr<UserService> userService;
+  std::shared_ptr<CompanyService> companyService;
+  std::shared_ptr<PasswordService> passwordService;
+  std::shared_ptr<RoomService> roomService;
+  std::shared_ptr<SessionReaper> sessionReaper;
+  std::shared_ptr<module::TokenSigner> tokenSigner;
+  std::shared_ptr<module::LoginGuard> loginGuard;
+
+  static constexpr time_t sessionLifetime = 1800l; // 1800secs
+
+  void admit(const std::string &account, const std::string &address) {
+    if (loginGuard->admit(account, address) == false) {
+      auto msg = fmt::v9::format(
+          "AuthService : {} or {} is locked after failed logins", account,
+          address);
+      serverLogger->error(msg);
+      throw ThrottledException(msg);
+    }
+  }
+
+  pplx::task<R> refuse(std::string pw, std::string reason) {
+    /**
+     * An unknown account still costs one hash at the current cost, so the
+     * response time does not tell it from a wrong password
+     */
+    return passwordService->compareWithDummyPw(pw).then(
+        [this, reason](bool) -> R {
+          auto msg = fmt::v9::format("AutoService : {}", reason);
+          serverLogger->error(msg);
+          throw ServiceException(msg);
+        });
+  }
+
+  void settle(const std::string &account, const std::string &address,
+              bool matched) {
+    if (matched) {
+      loginGuard->succeed(account);
+    } else {
+      loginGuard->fail(account, address);
+    }
+  }
+
+  R openSession(R principal, bool matched, const std::string &who) {
     auto session = std::unique_ptr<mysqlx::Session>(nullptr);
     try {
-      session = std::make_unique<mysqlx::Session>(conn->client->getSession());
-      session->startTransaction();
+      if (matched) {
+        session =
+            std::make_unique<mysqlx::Session>(conn->client->getSession());
+        session->startTransaction();
 
-      auto serverSession =
-          serverSessionRepository->findById(*session, sessionId);
-      if (serverSession != nullptr) {
-        if (serverSessionRepository->remove(*session, serverSession)) {
+        auto expiredAt =
+            static_cast<time_t>(module::getCurrentTime() + sessionLifetime);
+        R serverSession =
+            std::make_shared<dao::ServerSession>(principal, expiredAt);
+        serverSession = serverSessionRepository->save(*session, serverSession);
+
+        if (serverSession != nullptr) {
+          sessionReaper->schedule(serverSession->getId(), expiredAt);
           session->commit();
-          return true;
+          return serverSession;
         } else {
-          throw NotRemovedEntityException(fmt::v9::format(
-              "AuthService : id={} cannot be removed", sessionId));
+          throw NotSavedEntityException(
+              fmt::v9::format("AuthService: {} cannot login", who));
         }
       } else {
-        throw NotFoundEntityException(fmt::v9::format(
-            "AuthService : id={} not in serverSession", sessionId));
-      }
-    } catch (const NotRemovedEntityException &e) {
-      if (session != nullptr) {
-        session->rollback();
+        throw NotSavedEntityException(
+            fmt::v9::format("AuthService: {} has different password", who));
       }
-      serverLogger->error(e.what());
-      throw;
-    } catch (const NotFoundEntityException &e) {
+    } catch (const NotSavedEntityException &e) {
       if (session != nullptr) {
         session->rollback();
       }
@@ -322,16 +343,56 @@ public:
     }
   }
 
-private:
-  static std::shared_ptr<AuthService> instance;
-  static std::mutex createMutex;
+  dao::Participant::TYPE roleOf(std::shared_ptr<dao::User> user,
+                                uint64_t roomId) {
+    /**
+     * session의 RoleCache에서 찾고, 없거나 그 사이 room의 participant가
+     * 바뀌었거나 RoleCache::ttl이 지났으면 DB에서 한 번 읽어 채운다
+     * (다른 node에서의 변경은 ttl이 지나야 보인다)
+     */
+    auto roles = user->getRoles();
+    if (roles == nullptr) {
+      return roomService->findRoleOf(user->getId(), roomId);
+    }
+    auto epoch = dao::RoleCache::epochOf(roomId);
+    auto cached = roles->find(roomId, epoch);
+    if (cached.has_value()) {
+      return *cached;
+    }
+    auto role = roomService->findRoleOf(user->getId(), roomId);
+    roles->store(roomId, role, epoch);
+    return role;
+  }
 
-  RP serverSessionRepository;
-  std::shared_ptr<UserService> userService;
-  std::shared_ptr<CompanyService> companyService;
-  std::shared_ptr<PasswordService> passwordService;
-  std::shared_ptr<RoomService> roomService;
-  const uint64_t tokenLength;
+  std::shared_ptr<dao::ServerSession>
+  adopt(const module::TokenSigner::Claims &claims) {
+    /**
+     * 다른 node(또는 재시작 전)가 발급한 token
+     * principal을 DB에서 읽어 cache
+     * 처음 보는 session이면 reaper에 만료 등록 (복원된 session은 이미 등록됨)
+     */
+    auto principal = R{nullptr};
+    try {
+      principal = (claims.type == module::TokenSigner::TYPE::COMPANY)
+                      ? companyService->findById(claims.principalId)
+                      : userService->findById(claims.principalId);
+    } catch (const NotFoundEntityException &e) {
+      // the principal has been removed since
+      return nullptr;
+    }
+    if (isUser(principal)) {
+      std::dynamic_pointer_cast<dao::User>(principal)->setRoles(
+          std::make_shared<dao::RoleCache>());
+    }
+
+    auto [serverSession, inserted] = serverSessionRepository->emplace(
+        std::make_shared<dao::ServerSession>(principal, claims.expiredAt,
+                                             claims.sessionId));
+    if (inserted) {
+      sessionReaper->schedule(claims.sessionId, claims.expiredAt);
+    }
+    return serverSession;
+  }
 
   AuthService() = delete;
 };
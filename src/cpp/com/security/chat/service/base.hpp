@@ -9,6 +9,8 @@
 
 #include <spdlog/logger.h>
 
+#include <algorithm>
+#include <list>
 #include <memory>
 
 namespace chat::service {
@@ -21,6 +23,34 @@ public:
   using CN = std::shared_ptr<module::Connection>;
   using RP = std::shared_ptr<dao::BaseRepository>;
 
+  struct Page {
+    std::list<R> entities;
+    // 다음 page의 after, 0이면 마지막 page
+    uint64_t next;
+    dao::BaseRepository::Version version;
+  };
+
+  static Page pageOf(std::list<R> entities, uint64_t limit) {
+    /**
+     * entities : repository에서 id 순서로 limit + 1개까지 읽은 결과
+     * limit + 1번째가 있으면 다음 page가 있다.
+     * version은 읽은 row 전체로 계산해서, 다음 page의 유무가 바뀌어도
+     * 달라진다
+     */
+    auto page = Page{{}, 0, {entities.size(), 0, 0}};
+    for (const auto &entity : entities) {
+      page.version.lastModifiedAt =
+          std::max(page.version.lastModifiedAt, entity->getLastModifiedAt());
+      page.version.createdAtSum += entity->getCreatedAt();
+    }
+    if (entities.size() > limit) {
+      entities.resize(limit);
+      page.next = entities.back()->getId();
+    }
+    page.entities = std::move(entities);
+    return page;
+  }
+
 protected:
   L serverLogger;
   CN conn;
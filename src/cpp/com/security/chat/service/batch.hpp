@@ -0,0 +1,144 @@
+#pragma once
+
+#include "../dao/company/entity.hpp"
+#include "../dao/company/repository.hpp"
+#include "../dao/participant/entity.hpp"
+#include "../dao/participant/repository.hpp"
+#include "../dao/room/entity.hpp"
+#include "../dao/room/repository.hpp"
+#include "../dao/user/entity.hpp"
+#include "../dao/user/repository.hpp"
+
+#include "../module/all.hpp"
+using namespace chat::module::exception;
+
+#include "base.hpp"
+
+#include <mysqlx/xdevapi.h>
+
+#include <fmt/core.h>
+
+#include <exception>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace chat::service {
+
+class BatchService : public BaseService {
+  /**
+   * 여러 조회를 하나의 mysqlx::Session, 하나의 transaction에서 실행
+   * 각 조회의 결과는 같은 snapshot에서 읽은 값이다
+   */
+public:
+  enum class TARGET {
+    COMPANY,
+    USER,
+    USERS_IN_COMPANY,
+    ROOM,
+    ROOMS,
+    PARTICIPANT,
+    PARTICIPANTS_IN_ROOM
+  };
+
+  struct Query {
+    TARGET target;
+    uint64_t id;
+    // list 조회의 page : id > after 인 row를 limit개까지
+    uint64_t after = 0;
+    uint64_t limit = 0;
+  };
+
+  static std::shared_ptr<BatchService> getInstance(L serverLogger, CN conn) {
+    std::lock_guard<std::mutex> lock(createMutex);
+    if (instance == nullptr) {
+      instance = std::make_shared<BatchService>(serverLogger, conn);
+    }
+    return instance;
+  }
+  BatchService(L serverLogger, CN conn)
+      : BaseService(serverLogger, conn),
+        companyRepository(dao::CompanyRepository::getInstance(serverLogger)),
+        userRepository(dao::UserRepository::getInstance(serverLogger)),
+        roomRepository(dao::RoomRepository::getInstance(serverLogger)),
+        participantRepository(
+            dao::ParticipantRepository::getInstance(serverLogger)) {}
+
+  std::vector<std::list<R>> findAll(const std::vector<Query> &queries) {
+    /**
+     * The result of each query is a list, empty when nothing was found.
+     * A single lookup returns at most one element, a list lookup at most
+     * limit + 1 so that the caller can tell whether a next page exists
+     */
+    auto session = std::unique_ptr<mysqlx::Session>(nullptr);
+    try {
+      session = std::make_unique<mysqlx::Session>(conn->client->getSession());
+      session->startTransaction();
+
+      auto results = std::vector<std::list<R>>{};
+      results.reserve(queries.size());
+      for (const auto &query : queries) {
+        results.emplace_back(find(*session, query));
+      }
+      session->commit();
+      return results;
+    } catch (const std::exception &e) {
+      if (session != nullptr) {
+        session->rollback();
+      }
+      auto msg = fmt::v9::format("BatchService : {}", e.what());
+      serverLogger->error(msg);
+      throw ServiceException(msg);
+    }
+  }
+
+private:
+  std::list<R> find(mysqlx::Session &session, const Query &query) {
+    auto entity = R{nullptr};
+    switch (query.target) {
+    case TARGET::COMPANY:
+      entity = companyRepository->findById(session, query.id);
+      break;
+    case TARGET::USER:
+      entity = userRepository->findById(session, query.id);
+      break;
+    case TARGET::USERS_IN_COMPANY:
+      return std::dynamic_pointer_cast<dao::UserRepository>(userRepository)
+          ->findAllByCompanyIdAfter(session, query.id, query.after,
+                                    query.limit + 1);
+    case TARGET::ROOM:
+      entity = roomRepository->findById(session, query.id);
+      break;
+    case TARGET::ROOMS:
+      return std::dynamic_pointer_cast<dao::RoomRepository>(roomRepository)
+          ->findAllAfter(session, query.after, query.limit + 1);
+    case TARGET::PARTICIPANT:
+      entity = participantRepository->findById(session, query.id);
+      break;
+    case TARGET::PARTICIPANTS_IN_ROOM:
+      return std::dynamic_pointer_cast<dao::ParticipantRepository>(
+                 participantRepository)
+          ->findAllInRoomAfter(session, query.id, query.after,
+                               query.limit + 1);
+    }
+    if (entity == nullptr) {
+      return {};
+    }
+    return {entity};
+  }
+
+  static std::shared_ptr<BatchService> instance;
+  static std::mutex createMutex;
+
+  RP companyRepository;
+  RP userRepository;
+  RP roomRepository;
+  RP participantRepository;
+  BatchService() = delete;
+};
+
+std::shared_ptr<BatchService> BatchService::instance = nullptr;
+std::mutex BatchService::createMutex{};
+} // namespace chat::service
@@ -13,6 +13,8 @@ using namespace chat::module::exception;
 
 #include <fmt/core.h>
 
+#include <pplx/pplxtasks.h>
+
 #include <exception>
 #include <memory>
 #include <mutex>
@@ -154,14 +156,33 @@ public:
     }
   }
 
-  R updatePw(uint64_t companyId, std::string pw) {
+  pplx::task<R> updatePw(uint64_t companyId, std::string pw) {
+    /**
+     * The password is hashed on the PasswordHasher pool, and stored in the
+     * continuation, so no thread waits for the hash and the transaction
+     * never waits for the pool
+     */
+    return passwordService->prepareForCompany(companyId, pw)
+        .then([this, companyId](PasswordService::Prepared prepared) {
+          return updatePw(companyId, prepared);
+        });
+  }
+
+private:
+  static std::shared_ptr<CompanyService> instance;
+  static std::mutex createMutex;
+
+  RP companyRepository;
+  std::shared_ptr<PasswordService> passwordService;
+
+  R updatePw(uint64_t companyId, const PasswordService::Prepared &prepared) {
     auto session = std::unique_ptr<mysqlx::Session>(nullptr);
     try {
       session = std::make_unique<mysqlx::Session>(conn->client->getSession());
       session->startTransaction();
       auto company = companyRepository->findById(*session, companyId);
       if (company != nullptr) {
-        passwordService->updateCompanyPw(*session, companyId, pw);
+        passwordService->updateCompanyPw(*session, companyId, prepared);
         session->commit();
         return company;
       } else {
@@ -184,13 +205,6 @@ public:
     }
   }
 
-private:
-  static std::shared_ptr<CompanyService> instance;
-  static std::mutex createMutex;
-
-  RP companyRepository;
-  std::shared_ptr<PasswordService> passwordService;
-
   CompanyService() = delete;
 };
 
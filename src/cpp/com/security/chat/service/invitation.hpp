@@ -7,6 +7,7 @@
 using namespace chat::module::exception;
 
 #include "base.hpp"
+#include "mail.hpp"
 #include "room.hpp"
 #include "user.hpp"
 
@@ -14,13 +15,11 @@ using namespace chat::module::exception;
 
 #include <fmt/core.h>
 
-#include <cstdlib>
 #include <ctime>
 #include <exception>
 #include <memory>
 #include <mutex>
 #include <string>
-#include <thread>
 
 namespace chat::service {
 
@@ -39,7 +38,8 @@ public:
         invitationRepository(
             dao::InvitationRepository::getInstance(serverLogger)),
         userService(UserService::getInstance(serverLogger, conn)),
-        roomService(RoomService::getInstance(serverLogger, conn)) {}
+        roomService(RoomService::getInstance(serverLogger, conn)),
+        mailService(MailService::getInstance(serverLogger, conn)) {}
 
   R findById(uint64_t invitationId) {
     auto session = std::unique_ptr<mysqlx::Session>(nullptr);
@@ -210,6 +210,8 @@ public:
      * ExpiredAt : current + 30min
      * If userId & roomId already in invitation, don't re-generate invitation
      * Length = 8
+     * The code is mailed to the user : the mail is queued in the same
+     * transaction and sent by MailService after commit
      */
     constexpr auto codeLength = 8;
     constexpr time_t timeOffset = 1800l;
@@ -231,7 +233,9 @@ public:
         invitation = invitationRepository->save(*session, invitation);
 
         if (invitation != nullptr) {
+          queueEmail(*session, invitation);
           session->commit();
+          mailService->wake();
           return invitation;
         } else {
           throw NotSavedEntityException(fmt::v9::format(
@@ -267,76 +271,34 @@ public:
     }
   }
 
-  void sendEmail(uint64_t inviatationId) {
-    /**
-     * Use postfix
-     * Postfix runs in docker container named by "postfix"
-     */
-    auto session = std::unique_ptr<mysqlx::Session>(nullptr);
-    try {
-      session = std::make_unique<mysqlx::Session>(conn->client->getSession());
-      session->startTransaction();
-
-      auto invitation = invitationRepository->findById(*session, inviatationId);
-
-      if (invitation != nullptr) {
-        auto code = std::dynamic_pointer_cast<dao::Invitation>(invitation)
-                        ->getPassword();
-        auto userId =
-            std::dynamic_pointer_cast<dao::Invitation>(invitation)->getUserId();
-        auto roomId =
-            std::dynamic_pointer_cast<dao::Invitation>(invitation)->getRoomId();
-        auto user =
-            std::dynamic_pointer_cast<dao::User>(userService->findById(userId));
-        auto room =
-            std::dynamic_pointer_cast<dao::Room>(roomService->findById(roomId));
-
-        auto expiredAt = std::dynamic_pointer_cast<dao::Invitation>(invitation)
-                             ->getExpiredAt();
-
-        auto title = "[Secure Chat Service]";
-
-        auto msg = fmt::v9::format("Welcome, {}\n"
-                                   "Room {} invites you\n"
-                                   "Your verified Code is {}\n"
-                                   "ExpiredAt: {} (KST/Seoul)\n",
-                                   user->getName(), room->getName(), code,
-                                   module::convertToLocalTimeString(expiredAt));
-
-        auto cmd = fmt::v9::format(
-            "docker exec -it postfix bash -c 'echo \"{}\" | mail -s \"{}\" {}'",
-            msg, title, user->getEmail());
-
-        // Run with another thread
-        std::thread(system, cmd.c_str()).join();
-
-      } else {
-        throw NotFoundEntityException(fmt::v9::format(
-            "InvitationService : id={} not in Invitation", inviatationId));
-      }
-    } catch (const NotFoundEntityException &e) {
-      if (session != nullptr) {
-        session->rollback();
-      }
-      serverLogger->error(e.what());
-      throw;
-    } catch (const std::exception &e) {
-      if (session != nullptr) {
-        session->rollback();
-      }
-      auto msg = fmt::v9::format("InvitationService : {}", e.what());
-      serverLogger->error(msg);
-      throw ServiceException(msg);
-    }
+private:
+  void queueEmail(mysqlx::Session &session, R entity) {
+    auto invitation = std::dynamic_pointer_cast<dao::Invitation>(entity);
+    auto user = std::dynamic_pointer_cast<dao::User>(
+        userService->findById(invitation->getUserId()));
+    auto room = std::dynamic_pointer_cast<dao::Room>(
+        roomService->findById(invitation->getRoomId()));
+
+    auto title = "[Secure Chat Service]";
+
+    auto msg = fmt::v9::format(
+        "Welcome, {}\n"
+        "Room {} invites you\n"
+        "Your verified Code is {}\n"
+        "ExpiredAt: {} (KST/Seoul)\n",
+        user->getName(), room->getName(), invitation->getPassword(),
+        module::convertToLocalTimeString(invitation->getExpiredAt()));
+
+    mailService->queue(session, user->getEmail(), title, msg);
   }
 
-private:
   static std::shared_ptr<InvitationService> instance;
   static std::mutex createMutex;
 
   RP invitationRepository;
   std::shared_ptr<UserService> userService;
   std::shared_ptr<RoomService> roomService;
+  std::shared_ptr<MailService> mailService;
 
   InvitationService() = delete;
 };
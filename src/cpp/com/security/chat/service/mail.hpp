@@ -0,0 +1,285 @@
+#pragma once
+
+#include "../dao/mail/entity.hpp"
+#include "../dao/mail/repository.hpp"
+
+#include "../module/all.hpp"
+#include "../module/smtp.hpp"
+using namespace chat::module::exception;
+
+#include "base.hpp"
+
+#include <mysqlx/xdevapi.h>
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <ctime>
+#include <exception>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace chat::service {
+
+class MailService : public BaseService {
+  /**
+   * Outbound mail queue
+   * queue() writes the mail into outbox_mail in the caller's transaction,
+   * so it is sent if and only if that transaction commits, and survives a
+   * restart. `workers` background threads claim due mails in batches of
+   * `batch`, deliver a batch over one SMTP connection to the relay, delete
+   * what was delivered and push the rest back with exponential backoff.
+   * Delivery is at least once : a mail whose result could not be recorded
+   * is sent again once its lease runs out
+   *
+   * metrics
+   *  - mail.sent : 전달된 mail 수 (누적)
+   *  - mail.retried : 다시 시도하도록 미룬 수 (누적)
+   *  - mail.dropped : relay가 거절했거나 maxAttempts를 넘겨 버린 수 (누적)
+   */
+public:
+  struct Relay {
+    std::string host;
+    uint16_t port;
+    std::string from;
+    std::string helo;
+    uint64_t workers;
+    uint64_t batch;
+  };
+
+  static std::shared_ptr<MailService>
+  getInstance(L serverLogger, CN conn,
+              Relay relay = {"127.0.0.1", 25, "noreply@localhost",
+                             "localhost", 1, 32}) {
+    // the relay of the first call is kept
+    std::lock_guard<std::mutex> lock(createMutex);
+    if (instance == nullptr) {
+      instance = std::make_shared<MailService>(serverLogger, conn, relay);
+    }
+    return instance;
+  }
+
+  MailService(L serverLogger, CN conn, Relay relay)
+      : BaseService(serverLogger, conn),
+        mailRepository(dao::MailRepository::getInstance(serverLogger)),
+        relay(relay), stopped(false), woken(false),
+        sentMetric(module::Metrics::getInstance()->at("mail.sent")),
+        retriedMetric(module::Metrics::getInstance()->at("mail.retried")),
+        droppedMetric(module::Metrics::getInstance()->at("mail.dropped")) {
+    for (uint64_t i = 0; i < std::max<uint64_t>(1, relay.workers); ++i) {
+      threads.emplace_back(&MailService::run, this);
+    }
+  }
+
+  ~MailService() { stop(); }
+
+  R queue(mysqlx::Session &session, std::string recipient,
+          std::string subject, std::string body) {
+    /**
+     * Call wake() after the caller commits, or the mail waits for the
+     * next poll
+     */
+    auto mail = std::make_shared<dao::Mail>(recipient, subject, body, 0,
+                                            module::getCurrentTime());
+    auto saved = mailRepository->save(session, mail);
+    if (saved == nullptr) {
+      throw NotSavedEntityException(fmt::v9::format(
+          "MailService : mail to {} cannot be queued", recipient));
+    }
+    return saved;
+  }
+
+  void wake() {
+    {
+      std::lock_guard<std::mutex> lock(wakeMutex);
+      woken = true;
+    }
+    wakeCond.notify_one();
+  }
+
+  void stop() {
+    {
+      std::lock_guard<std::mutex> lock(wakeMutex);
+      if (stopped) {
+        return;
+      }
+      stopped = true;
+    }
+    wakeCond.notify_all();
+    for (auto &thread : threads) {
+      if (thread.joinable()) {
+        thread.join();
+      }
+    }
+  }
+
+private:
+  void run() {
+    std::unique_lock<std::mutex> lock(wakeMutex);
+    while (stopped == false) {
+      lock.unlock();
+      bool more = false;
+      try {
+        more = deliver(module::getCurrentTime());
+      } catch (const std::exception &e) {
+        serverLogger->error(fmt::v9::format("MailService : {}", e.what()));
+      }
+      lock.lock();
+      if (more) {
+        // a full batch : more may be due already
+        continue;
+      }
+      wakeCond.wait_for(lock, pollInterval,
+                        [this]() { return stopped || woken; });
+      woken = false;
+    }
+  }
+
+  bool deliver(time_t now) {
+    auto claimed = claim(now);
+    if (claimed.empty()) {
+      return false;
+    }
+
+    auto mails = std::vector<std::shared_ptr<dao::Mail>>{};
+    for (const auto &entity : claimed) {
+      mails.emplace_back(std::dynamic_pointer_cast<dao::Mail>(entity));
+    }
+
+    auto sent = std::list<R>{};
+    auto dropped = std::list<R>{};
+    auto retried = std::list<R>{};
+    size_t settled = 0;
+    try {
+      auto client = module::SmtpClient(relay.host, relay.port, relay.helo);
+      client.open();
+      for (; settled < mails.size(); ++settled) {
+        const auto &mail = mails[settled];
+        auto reply = client.send(relay.from, mail->getRecipient(),
+                                 mail->getSubject(), mail->getBody());
+        if (reply.isOk()) {
+          sent.emplace_back(mail);
+        } else {
+          serverLogger->error(
+              fmt::v9::format("MailService : mail(id={}) to {} -> {} {}",
+                              mail->getId(), mail->getRecipient(),
+                              reply.code, reply.text));
+          (reply.isPermanent() ? dropped : retried).emplace_back(mail);
+        }
+      }
+      client.close();
+    } catch (const std::exception &e) {
+      // the relay is unreachable or hung up : the rest of the batch waits
+      serverLogger->error(fmt::v9::format("MailService : {}", e.what()));
+      for (; settled < mails.size(); ++settled) {
+        retried.emplace_back(mails[settled]);
+      }
+    }
+
+    for (auto iter = retried.begin(); iter != retried.end();) {
+      auto mail = std::dynamic_pointer_cast<dao::Mail>(*iter);
+      if (mail->getAttempts() >= maxAttempts) {
+        serverLogger->error(fmt::v9::format(
+            "MailService : mail(id={}) to {} dropped after {} attempts",
+            mail->getId(), mail->getRecipient(), mail->getAttempts()));
+        dropped.emplace_back(mail);
+        iter = retried.erase(iter);
+      } else {
+        // 30s, 60s, 120s ... 1h
+        auto exponent = std::min<uint32_t>(mail->getAttempts() - 1, 16);
+        mail->setNextAt(now + std::min(maxBackoff, minBackoff << exponent));
+        ++iter;
+      }
+    }
+    record(sent, dropped, retried);
+
+    sentMetric.fetch_add(sent.size(), std::memory_order_relaxed);
+    droppedMetric.fetch_add(dropped.size(), std::memory_order_relaxed);
+    retriedMetric.fetch_add(retried.size(), std::memory_order_relaxed);
+    return claimed.size() == relay.batch;
+  }
+
+  std::list<R> claim(time_t now) {
+    auto session = std::unique_ptr<mysqlx::Session>(nullptr);
+    try {
+      session = std::make_unique<mysqlx::Session>(conn->client->getSession());
+      session->startTransaction();
+
+      auto mails = std::dynamic_pointer_cast<dao::MailRepository>(
+                       mailRepository)
+                       ->claimDue(*session, now, lease, relay.batch);
+      session->commit();
+      return mails;
+    } catch (const std::exception &e) {
+      if (session != nullptr) {
+        session->rollback();
+      }
+      auto msg = fmt::v9::format("MailService : {}", e.what());
+      serverLogger->error(msg);
+      throw ServiceException(msg);
+    }
+  }
+
+  void record(const std::list<R> &sent, const std::list<R> &dropped,
+              const std::list<R> &retried) {
+    auto session = std::unique_ptr<mysqlx::Session>(nullptr);
+    try {
+      session = std::make_unique<mysqlx::Session>(conn->client->getSession());
+      session->startTransaction();
+
+      for (const auto &mail : sent) {
+        mailRepository->remove(*session, mail);
+      }
+      for (const auto &mail : dropped) {
+        mailRepository->remove(*session, mail);
+      }
+      for (const auto &mail : retried) {
+        mailRepository->update(*session, mail);
+      }
+      session->commit();
+    } catch (const std::exception &e) {
+      if (session != nullptr) {
+        session->rollback();
+      }
+      auto msg = fmt::v9::format("MailService : {}", e.what());
+      serverLogger->error(msg);
+      throw ServiceException(msg);
+    }
+  }
+
+  static constexpr auto pollInterval = std::chrono::seconds(5);
+  // a claimed mail is handed to another worker after this many secs
+  static constexpr time_t lease = 600l;
+  static constexpr time_t minBackoff = 30l;
+  static constexpr time_t maxBackoff = 3600l;
+  static constexpr uint32_t maxAttempts = 10;
+
+  static std::shared_ptr<MailService> instance;
+  static std::mutex createMutex;
+
+  RP mailRepository;
+  Relay relay;
+
+  std::mutex wakeMutex;
+  std::condition_variable wakeCond;
+  bool stopped;
+  bool woken;
+  std::vector<std::thread> threads;
+
+  module::Metrics::V &sentMetric;
+  module::Metrics::V &retriedMetric;
+  module::Metrics::V &droppedMetric;
+
+  MailService() = delete;
+};
+
+std::shared_ptr<MailService> MailService::instance = nullptr;
+std::mutex MailService::createMutex{};
+} // namespace chat::service
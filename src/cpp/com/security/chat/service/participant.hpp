@@ -2,6 +2,7 @@
 
 #include "../dao/participant/entity.hpp"
 #include "../dao/participant/repository.hpp"
+#include "../dao/participant/role_cache.hpp"
 
 #include "../module/all.hpp"
 using namespace chat::module::exception;
@@ -104,7 +105,7 @@ public:
     }
   }
 
-  std::list<R> findAllInRoom(uint64_t roomId) {
+  Page findAllInRoom(uint64_t roomId, uint64_t after, uint64_t limit) {
     auto session = std::unique_ptr<mysqlx::Session>(nullptr);
     try {
       session = std::make_unique<mysqlx::Session>(conn->client->getSession());
@@ -112,10 +113,10 @@ public:
       auto participantList =
           std::dynamic_pointer_cast<dao::ParticipantRepository>(
               participantRepository)
-              ->findAllInRoom(*session, roomId);
+              ->findAllInRoomAfter(*session, roomId, after, limit + 1);
       if (participantList.size() > 0) {
         session->commit();
-        return participantList;
+        return pageOf(participantList, limit);
       } else {
         throw NotFoundEntityException(fmt::v9::format(
             "ParticipantService: room={} not in Participant", roomId));
@@ -181,6 +182,7 @@ public:
 
       if (participant != nullptr) {
         session->commit();
+        dao::RoleCache::invalidate(roomId);
         return participant;
       } else {
         throw NotSavedEntityException(fmt::v9::format(
@@ -243,6 +245,7 @@ public:
 
       if (participantRepository->remove(*session, participant)) {
         session->commit();
+        dao::RoleCache::invalidate(roomId);
         return true;
       } else {
         throw NotRemovedEntityException(fmt::v9::format(
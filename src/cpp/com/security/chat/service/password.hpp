@@ -4,10 +4,13 @@
 #include "../dao/company/repository.hpp"
 #include "../dao/password/entity.hpp"
 #include "../dao/password/repository.hpp"
+#include "../dao/server_session/entity.hpp"
+#include "../dao/server_session/memory_repository.hpp"
 #include "../dao/user/entity.hpp"
 #include "../dao/user/repository.hpp"
 
 #include "../module/all.hpp"
+#include "../module/hasher.hpp"
 using namespace chat::module::exception;
 
 #include "base.hpp"
@@ -16,6 +19,8 @@ using namespace chat::module::exception;
 
 #include <fmt/core.h>
 
+#include <pplx/pplxtasks.h>
+
 #include <exception>
 #include <memory>
 #include <mutex>
@@ -37,7 +42,10 @@ public:
         passwordRepository(dao::PasswordRepository::getInstance(serverLogger)),
         userRepository(dao::UserRepository::getInstance(serverLogger)),
         companyRepository(dao::CompanyRepository::getInstance(serverLogger)),
-        saltLength(100) {}
+        serverSessionRepository(
+            dao::ServerSessionRepository::getInstance(serverLogger)),
+        hasher(module::PasswordHasher::getInstance()), saltLength(100),
+        dummySalt(module::secure::generateFixedLengthCode(saltLength)) {}
 
   R findByCompanyId(uint64_t companyId) {
     auto session = std::unique_ptr<mysqlx::Session>(nullptr);
@@ -101,7 +109,12 @@ public:
     }
   }
 
-  bool compareWithCompanyPw(uint64_t companyId, std::string receivedPw) {
+  pplx::task<bool> compareWithCompanyPw(uint64_t companyId,
+                                        std::string receivedPw) {
+    /**
+     * The hash is compared on the PasswordHasher pool; no thread waits for it.
+     * A row hashed below the current cost is rehashed once it has matched
+     */
     auto session = std::unique_ptr<mysqlx::Session>(nullptr);
     try {
       session = std::make_unique<mysqlx::Session>(conn->client->getSession());
@@ -111,12 +124,16 @@ public:
               ->findByCompanyId(*session, companyId);
       session->commit();
       if (password != nullptr) {
-        auto salt =
-            std::dynamic_pointer_cast<dao::Password>(password)->getSalt();
-        auto storedPw =
-            std::dynamic_pointer_cast<dao::Password>(password)->getHashedPw();
-
-        return module::secure::compare(receivedPw, storedPw, salt);
+        auto stored = std::dynamic_pointer_cast<dao::Password>(password);
+        return hasher
+            ->compare(receivedPw, stored->getHashedPw(), stored->getSalt(),
+                      stored->getCost())
+            .then([this, stored, receivedPw](bool matched) {
+              if (matched && (stored->getCost() < hasher->getCost())) {
+                rehash(stored, receivedPw);
+              }
+              return matched;
+            });
       } else {
         throw NotFoundEntityException(fmt::v9::format(
             "PasswordService: company={} not in Password", companyId));
@@ -127,6 +144,9 @@ public:
       }
       serverLogger->error(e.what());
       throw;
+    } catch (const OverloadedException &e) {
+      serverLogger->error(e.what());
+      throw;
     } catch (const std::exception &e) {
       if (session != nullptr) {
         session->rollback();
@@ -137,7 +157,11 @@ public:
     }
   }
 
-  bool compareWithUserPw(uint64_t userId, std::string receivedPw) {
+  pplx::task<bool> compareWithUserPw(uint64_t userId, std::string receivedPw) {
+    /**
+     * The hash is compared on the PasswordHasher pool; no thread waits for it.
+     * A row hashed below the current cost is rehashed once it has matched
+     */
     auto session = std::unique_ptr<mysqlx::Session>(nullptr);
     try {
       session = std::make_unique<mysqlx::Session>(conn->client->getSession());
@@ -147,12 +171,16 @@ public:
               ->findByUserId(*session, userId);
       session->commit();
       if (password != nullptr) {
-        auto salt =
-            std::dynamic_pointer_cast<dao::Password>(password)->getSalt();
-        auto storedPw =
-            std::dynamic_pointer_cast<dao::Password>(password)->getHashedPw();
-
-        return module::secure::compare(receivedPw, storedPw, salt);
+        auto stored = std::dynamic_pointer_cast<dao::Password>(password);
+        return hasher
+            ->compare(receivedPw, stored->getHashedPw(), stored->getSalt(),
+                      stored->getCost())
+            .then([this, stored, receivedPw](bool matched) {
+              if (matched && (stored->getCost() < hasher->getCost())) {
+                rehash(stored, receivedPw);
+              }
+              return matched;
+            });
       } else {
         throw NotFoundEntityException(fmt::v9::format(
             "PasswordService: user={} not in Password", userId));
@@ -163,6 +191,9 @@ public:
       }
       serverLogger->error(e.what());
       throw;
+    } catch (const OverloadedException &e) {
+      serverLogger->error(e.what());
+      throw;
     } catch (const std::exception &e) {
       if (session != nullptr) {
         session->rollback();
@@ -173,29 +204,89 @@ public:
     }
   }
 
+  struct Prepared {
+    /**
+     * A new password, hashed before the transaction that stores it, so that
+     * no transaction waits for the hashing pool
+     * unchanged : it matches the stored one, which is kept along with the
+     *             sessions (nothing is hashed)
+     */
+    bool unchanged;
+    std::string salt;
+    std::string hashedPw;
+    uint32_t cost;
+  };
+
+  pplx::task<Prepared> prepare(std::string pw) {
+    /**
+     * For saveWithUserId; resolved once the hashing pool is done, so call it
+     * outside of any transaction and store the result in its continuation
+     */
+    auto salt = module::secure::generateFixedLengthCode(saltLength);
+    auto cost = hasher->getCost();
+    return hasher->hash(pw, salt).then([salt, cost](std::string hashedPw) {
+      return Prepared{false, salt, hashedPw, cost};
+    });
+  }
+
+  pplx::task<Prepared> prepareForCompany(uint64_t companyId, std::string pw) {
+    // for updateCompanyPw; the same as prepare
+    return compareWithCompanyPw(companyId, pw)
+        .then([this, pw](bool unchanged) -> pplx::task<Prepared> {
+          if (unchanged) {
+            return pplx::task_from_result(Prepared{true, "", "", 0});
+          }
+          return prepare(pw);
+        });
+  }
+
+  pplx::task<Prepared> prepareForUser(uint64_t userId, std::string pw) {
+    // for updateUserPw; the same as prepare
+    return compareWithUserPw(userId, pw)
+        .then([this, pw](bool unchanged) -> pplx::task<Prepared> {
+          if (unchanged) {
+            return pplx::task_from_result(Prepared{true, "", "", 0});
+          }
+          return prepare(pw);
+        });
+  }
+
+  pplx::task<bool> compareWithDummyPw(std::string receivedPw) {
+    /**
+     * For a login of an unknown account : costs the same hash as a known
+     * one, against a fixed salt, and never matches
+     */
+    return hasher->compare(receivedPw, "", dummySalt, hasher->getCost());
+  }
+
   /**
    * update, save, and remove of password is done with user or company.
    * So, the session of passwordRepository MUST be same with user and company
    * repository
    */
   R updateCompanyPw(mysqlx::Session &session, uint64_t companyId,
-                    std::string updatedPw) {
+                    const Prepared &prepared) {
     try {
       auto password =
           std::dynamic_pointer_cast<dao::PasswordRepository>(passwordRepository)
               ->findByCompanyId(session, companyId);
       if (password != nullptr) {
-        auto salt = module::secure::generateFixedLengthCode(saltLength);
-        auto hashedPw = module::secure::hash(updatedPw, salt);
-
-        std::dynamic_pointer_cast<dao::Password>(password)->setHashedPw(
-            hashedPw);
-        std::dynamic_pointer_cast<dao::Password>(password)->setSalt(salt);
+        auto stored = std::dynamic_pointer_cast<dao::Password>(password);
+        if (prepared.unchanged) {
+          // keep the hash and the sessions
+          return password;
+        }
+        stored->setHashedPw(prepared.hashedPw);
+        stored->setSalt(prepared.salt);
+        stored->setCost(prepared.cost);
 
         password = std::dynamic_pointer_cast<dao::PasswordRepository>(
                        passwordRepository)
                        ->updateOfCompanyId(session, password);
         if (password != nullptr) {
+          // sessions logged in with the old password end here
+          serverSessionRepository->revokeAllOf(
+              {dao::ServerSession::TYPE::COMPANY, companyId});
           return password;
         } else {
           throw NotUpdatedEntityException(fmt::v9::format(
@@ -219,24 +310,28 @@ public:
   }
 
   R updateUserPw(mysqlx::Session &session, uint64_t userId,
-                 std::string updatedPw) {
+                 const Prepared &prepared) {
     try {
       auto password =
           std::dynamic_pointer_cast<dao::PasswordRepository>(passwordRepository)
               ->findByUserId(session, userId);
-
       if (password != nullptr) {
-        auto salt = module::secure::generateFixedLengthCode(saltLength);
-        auto hashedPw = module::secure::hash(updatedPw, salt);
-
-        std::dynamic_pointer_cast<dao::Password>(password)->setHashedPw(
-            hashedPw);
-        std::dynamic_pointer_cast<dao::Password>(password)->setSalt(salt);
+        auto stored = std::dynamic_pointer_cast<dao::Password>(password);
+        if (prepared.unchanged) {
+          // keep the hash and the sessions
+          return password;
+        }
+        stored->setHashedPw(prepared.hashedPw);
+        stored->setSalt(prepared.salt);
+        stored->setCost(prepared.cost);
 
         password = std::dynamic_pointer_cast<dao::PasswordRepository>(
                        passwordRepository)
                        ->updateOfUserId(session, password);
         if (password != nullptr) {
+          // sessions logged in with the old password end here
+          serverSessionRepository->revokeAllOf(
+              {dao::ServerSession::TYPE::USER, userId});
           return password;
         } else {
           throw NotUpdatedEntityException(fmt::v9::format(
@@ -259,7 +354,8 @@ public:
     }
   }
 
-  R saveWithUserId(mysqlx::Session &session, uint64_t userId, std::string pw) {
+  R saveWithUserId(mysqlx::Session &session, uint64_t userId,
+                   const Prepared &prepared) {
     try {
       auto password =
           std::dynamic_pointer_cast<dao::PasswordRepository>(passwordRepository)
@@ -272,10 +368,9 @@ public:
         auto userName = user->getName();
         auto createdAt = module::convertToLocalTimeString(user->getCreatedAt());
 
-        auto salt = module::secure::generateFixedLengthCode(saltLength);
-        auto hashedPw = module::secure::hash(pw, salt);
-
-        R password = std::make_shared<dao::Password>(userId, salt, hashedPw);
+        R password = std::make_shared<dao::Password>(
+            userId, prepared.salt, prepared.hashedPw, -1, -1, 0, 0,
+            prepared.cost);
         password = std::dynamic_pointer_cast<dao::PasswordRepository>(
                        passwordRepository)
                        ->saveWithUserId(session, password);
@@ -339,7 +434,49 @@ private:
   RP passwordRepository;
   RP companyRepository;
   RP userRepository;
+  std::shared_ptr<dao::ServerSessionRepository> serverSessionRepository;
+  std::shared_ptr<module::PasswordHasher> hasher;
   uint64_t saltLength;
+  std::string dummySalt;
+
+  void rehash(std::shared_ptr<dao::Password> password, std::string pw) {
+    /**
+     * Migrates a row to the current cost, off the login's path
+     * On failure (e.g. the hashing queue is full) a later login retries
+     */
+    auto salt = module::secure::generateFixedLengthCode(saltLength);
+    try {
+      hasher->hash(pw, salt)
+          .then([this, password, salt](std::string hashedPw) {
+            auto session = std::make_unique<mysqlx::Session>(
+                conn->client->getSession());
+            session->startTransaction();
+            password->setSalt(salt);
+            password->setHashedPw(hashedPw);
+            password->setCost(hasher->getCost());
+            auto repository =
+                std::dynamic_pointer_cast<dao::PasswordRepository>(
+                    passwordRepository);
+            if (password->getCompanyId() != uint64_t(-1)) {
+              repository->updateOfCompanyId(*session, password);
+            } else {
+              repository->updateOfUserId(*session, password);
+            }
+            session->commit();
+          })
+          .then([this](pplx::task<void> rehashed) {
+            try {
+              rehashed.get();
+            } catch (const std::exception &e) {
+              serverLogger->error(
+                  fmt::v9::format("PasswordService : rehash : {}", e.what()));
+            }
+          });
+    } catch (const std::exception &e) {
+      serverLogger->error(
+          fmt::v9::format("PasswordService : rehash : {}", e.what()));
+    }
+  }
   PasswordService() = delete;
 };
 
@@ -0,0 +1,152 @@
+#pragma once
+
+#include "../dao/server_session/memory_repository.hpp"
+
+#include "../module/all.hpp"
+#include "../module/timing_wheel.hpp"
+
+#include <fmt/core.h>
+
+#include <spdlog/logger.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <ctime>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace chat::service {
+
+class SessionReaper {
+  /**
+   * 만료된 ServerSession을 background thread에서 매초 삭제
+   * login 때 expiredAt으로 timing wheel에 등록하고, 시간이 되면 다시 확인해서
+   * 여전히 만료됐으면 삭제, 그 사이 연장됐으면 새 expiredAt으로 다시 등록.
+   * logout된 session은 revoke 기록이 만료될 때까지 같은 방식으로 다시 등록
+   *
+   * metrics
+   *  - session.live : 메모리에 있는 session 수
+   *  - session.expired : 만료로 삭제된 session 수 (누적)
+   *  - session.scheduled : timing wheel에 등록된 수
+   */
+public:
+  using L = std::shared_ptr<spdlog::logger>;
+  using RP = std::shared_ptr<dao::ServerSessionRepository>;
+
+  static std::shared_ptr<SessionReaper> getInstance(L serverLogger) {
+    std::lock_guard<std::mutex> lock(createMutex);
+    if (instance == nullptr) {
+      instance = std::make_shared<SessionReaper>(serverLogger);
+    }
+    return instance;
+  }
+
+  SessionReaper(L serverLogger)
+      : serverLogger(serverLogger),
+        serverSessionRepository(
+            dao::ServerSessionRepository::getInstance(serverLogger)),
+        wheel(module::getCurrentTime()), stopped(false),
+        liveMetric(module::Metrics::getInstance()->at("session.live")),
+        expiredMetric(module::Metrics::getInstance()->at("session.expired")),
+        scheduledMetric(
+            module::Metrics::getInstance()->at("session.scheduled")) {
+    thread = std::thread(&SessionReaper::run, this);
+  }
+
+  ~SessionReaper() { stop(); }
+
+  void schedule(uint64_t sessionId, time_t expiredAt) {
+    std::lock_guard<std::mutex> lock(wheelMutex);
+    wheel.schedule(sessionId, expiredAt);
+    scheduledMetric.store(wheel.size(), std::memory_order_relaxed);
+  }
+
+  void stop() {
+    {
+      std::lock_guard<std::mutex> lock(stopMutex);
+      if (stopped) {
+        return;
+      }
+      stopped = true;
+    }
+    stopCond.notify_all();
+    if (thread.joinable()) {
+      thread.join();
+    }
+  }
+
+private:
+  void run() {
+    std::unique_lock<std::mutex> lock(stopMutex);
+    while (stopCond.wait_for(lock, std::chrono::seconds(1),
+                             [this]() { return stopped; }) == false) {
+      lock.unlock();
+      try {
+        reap(module::getCurrentTime());
+      } catch (const std::exception &e) {
+        serverLogger->error(fmt::v9::format("SessionReaper : {}", e.what()));
+      }
+      lock.lock();
+    }
+  }
+
+  void reap(time_t now) {
+    auto due = std::vector<uint64_t>{};
+    {
+      std::lock_guard<std::mutex> lock(wheelMutex);
+      wheel.advance(now, [&due](uint64_t sessionId) {
+        due.emplace_back(sessionId);
+      });
+    }
+
+    int64_t expired = 0;
+    for (auto sessionId : due) {
+      auto expiredAt = serverSessionRepository->removeIfExpired(sessionId, now);
+      if (expiredAt == 0) {
+        // logged out, and its token has expired
+        continue;
+      } else if (expiredAt <= now) {
+        ++expired;
+      } else {
+        schedule(sessionId, expiredAt);
+      }
+    }
+
+    // journal이 snapshot보다 커졌으면 snapshot을 새로 쓴다
+    serverSessionRepository->compact();
+
+    expiredMetric.fetch_add(expired, std::memory_order_relaxed);
+    liveMetric.store(serverSessionRepository->size(),
+                     std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(wheelMutex);
+    scheduledMetric.store(wheel.size(), std::memory_order_relaxed);
+  }
+
+  static std::shared_ptr<SessionReaper> instance;
+  static std::mutex createMutex;
+
+  L serverLogger;
+  RP serverSessionRepository;
+
+  std::mutex wheelMutex;
+  module::TimingWheel wheel;
+
+  std::mutex stopMutex;
+  std::condition_variable stopCond;
+  bool stopped;
+  std::thread thread;
+
+  module::Metrics::V &liveMetric;
+  module::Metrics::V &expiredMetric;
+  module::Metrics::V &scheduledMetric;
+
+  SessionReaper() = delete;
+};
+
+std::shared_ptr<SessionReaper> SessionReaper::instance = nullptr;
+std::mutex SessionReaper::createMutex{};
+} // namespace chat::service
@@ -2,6 +2,7 @@
 
 #include "../dao/participant/entity.hpp"
 #include "../dao/participant/repository.hpp"
+#include "../dao/participant/role_cache.hpp"
 #include "../dao/room/entity.hpp"
 #include "../dao/room/repository.hpp"
 
@@ -97,17 +98,17 @@ public:
     }
   }
 
-  std::list<R> findAll() {
+  Page findAll(uint64_t after, uint64_t limit) {
     auto session = std::unique_ptr<mysqlx::Session>(nullptr);
     try {
       session = std::make_unique<mysqlx::Session>(conn->client->getSession());
       session->startTransaction();
       auto roomList =
           std::dynamic_pointer_cast<dao::RoomRepository>(roomRepository)
-              ->findAll(*session);
+              ->findAllAfter(*session, after, limit + 1);
       if (roomList.size() > 0) {
         session->commit();
-        return roomList;
+        return pageOf(roomList, limit);
       } else {
         throw NotFoundEntityException(
             fmt::v9::format("RoomService: nothing in Room"));
@@ -133,6 +134,33 @@ public:
         fmt::v9::format("RoomService: findALlInCompany not implemented"));
   }
 
+  dao::Participant::TYPE findRoleOf(uint64_t userId, uint64_t roomId) {
+    /**
+     * role of the user in the room, INVALID if not a participant
+     */
+    auto session = std::unique_ptr<mysqlx::Session>(nullptr);
+    try {
+      session = std::make_unique<mysqlx::Session>(conn->client->getSession());
+      session->startTransaction();
+      auto participant = std::dynamic_pointer_cast<dao::ParticipantRepository>(
+                             participantRepository)
+                             ->findByUserIdInRoom(*session, userId, roomId);
+      session->commit();
+      if (participant == nullptr) {
+        return dao::Participant::TYPE::INVALID;
+      }
+      return dao::Participant::convertToType(
+          std::dynamic_pointer_cast<dao::Participant>(participant)->getRole());
+    } catch (const std::exception &e) {
+      if (session != nullptr) {
+        session->rollback();
+      }
+      auto msg = fmt::v9::format("RoomService : {}", e.what());
+      serverLogger->error(msg);
+      throw ServiceException(msg);
+    }
+  }
+
   R findHost(uint64_t roomId) {
     /**
      * Only one host is permitted
@@ -342,6 +370,7 @@ public:
         }
         if (roomRepository->remove(*session, room)) {
           session->commit();
+          dao::RoleCache::invalidate(roomId);
           return true;
         } else {
           throw NotRemovedEntityException(
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "../dao/server_session/entity.hpp"
+#include "../dao/server_session/memory_repository.hpp"
 #include "../dao/user/entity.hpp"
 #include "../dao/user/repository.hpp"
 
@@ -14,6 +16,8 @@ using namespace chat::module::exception;
 
 #include <fmt/core.h>
 
+#include <pplx/pplxtasks.h>
+
 #include <exception>
 #include <list>
 #include <memory>
@@ -35,7 +39,9 @@ public:
       : BaseService(serverLogger, conn),
         userRepository(dao::UserRepository::getInstance(serverLogger)),
         companyService(CompanyService::getInstance(serverLogger, conn)),
-        passwordService(PasswordService::getInstance(serverLogger, conn)) {}
+        passwordService(PasswordService::getInstance(serverLogger, conn)),
+        serverSessionRepository(
+            dao::ServerSessionRepository::getInstance(serverLogger)) {}
 
   R findById(uint64_t userId) {
     auto session = std::unique_ptr<mysqlx::Session>(nullptr);
@@ -158,17 +164,17 @@ public:
       throw ServiceException(msg);
     }
   }
-  std::list<R> findAllInCompany(uint64_t companyId) {
+  Page findAllInCompany(uint64_t companyId, uint64_t after, uint64_t limit) {
     auto session = std::unique_ptr<mysqlx::Session>(nullptr);
     try {
       session = std::make_unique<mysqlx::Session>(conn->client->getSession());
       session->startTransaction();
       auto userList =
           std::dynamic_pointer_cast<dao::UserRepository>(userRepository)
-              ->findAllByCompanyId(*session, companyId);
+              ->findAllByCompanyIdAfter(*session, companyId, after, limit + 1);
       if (userList.size() > 0) {
         session->commit();
-        return userList;
+        return pageOf(userList, limit);
       } else {
         throw NotFoundEntityException(
             fmt::v9::format("UserService: company={} not in User", companyId));
@@ -189,8 +195,85 @@ public:
     }
   }
 
+  pplx::task<R> save(std::string name, uint64_t companyId, std::string role,
+                     std::string email, std::string pw) {
+    /**
+     * The password is hashed on the PasswordHasher pool, and the user is
+     * stored in the continuation, so no thread waits for the hash and the
+     * transaction never waits for the pool
+     */
+    return passwordService->prepare(pw).then(
+        [this, name, companyId, role,
+         email](PasswordService::Prepared prepared) {
+          return save(name, companyId, role, email, prepared);
+        });
+  }
+
+  pplx::task<R> update(uint64_t userId, std::string name, std::string role,
+                       std::string email, std::string pw) {
+    // the same as save
+    return passwordService->prepareForUser(userId, pw)
+        .then([this, userId, name, role,
+               email](PasswordService::Prepared prepared) {
+          return update(userId, name, role, email, prepared);
+        });
+  }
+
+  bool remove(uint64_t userId) {
+    auto session = std::unique_ptr<mysqlx::Session>(nullptr);
+    try {
+      session = std::make_unique<mysqlx::Session>(conn->client->getSession());
+      session->startTransaction();
+
+      auto user = userRepository->findById(*session, userId);
+      if (user != nullptr) {
+        if (passwordService->removeUserPw(*session, userId)) {
+          userRepository->remove(*session, user);
+          session->commit();
+          serverSessionRepository->revokeAllOf(
+              {dao::ServerSession::TYPE::USER, userId});
+          return true;
+        } else {
+          throw NotRemovedEntityException(
+              fmt::v9::format("UserService: id={} cannot be removed", userId));
+        }
+      } else {
+        throw NotFoundEntityException(
+            fmt::v9::format("UserService: id={} not in User", userId));
+      }
+    } catch (const NotFoundEntityException &e) {
+      if (session != nullptr) {
+        session->rollback();
+      }
+      serverLogger->error(e.what());
+      throw;
+    } catch (const NotRemovedEntityException &e) {
+      if (session != nullptr) {
+        session->rollback();
+      }
+      serverLogger->error(e.what());
+      throw;
+    } catch (const std::exception &e) {
+      if (session != nullptr) {
+        session->rollback();
+      }
+      auto msg = fmt::v9::format("UserService : {}", e.what());
+      serverLogger->error(msg);
+      throw ServiceException(msg);
+    }
+  }
+
+private:
+  static std::shared_ptr<UserService> instance;
+  static std::mutex createMutex;
+
+  RP userRepository;
+  std::shared_ptr<CompanyService> companyService;
+  std::shared_ptr<PasswordService> passwordService;
+  std::shared_ptr<dao::ServerSessionRepository> serverSessionRepository;
+
   R save(std::string name, uint64_t companyId, std::string role,
-         std::string email, std::string pw) {
+         std::string email, const PasswordService::Prepared &prepared) {
     auto session = std::unique_ptr<mysqlx::Session>(nullptr);
     try {
       session = std::make_unique<mysqlx::Session>(conn->client->getSession());
@@ -204,7 +287,7 @@ public:
         R user = std::make_shared<dao::User>(companyId, name, role, email);
         user = userRepository->save(*session, user);
         if (user != nullptr) {
-          passwordService->saveWithUserId(*session, user->getId(), pw);
+          passwordService->saveWithUserId(*session, user->getId(), prepared);
           session->commit();
           return user;
         } else {
@@ -241,8 +324,7 @@ public:
   }
 
   R update(uint64_t userId, std::string name, std::string role,
-           std::string email, std::string pw) {
-
+           std::string email, const PasswordService::Prepared &prepared) {
     auto session = std::unique_ptr<mysqlx::Session>(nullptr);
     try {
       session = std::make_unique<mysqlx::Session>(conn->client->getSession());
@@ -261,7 +343,7 @@ public:
 
           user = std::dynamic_pointer_cast<dao::User>(
               userRepository->update(*session, user));
-          passwordService->updateUserPw(*session, userId, pw);
+          passwordService->updateUserPw(*session, userId, prepared);
           if (user != nullptr) {
             session->commit();
             return user;
@@ -309,56 +391,6 @@ public:
     }
   }
 
-  bool remove(uint64_t userId) {
-    auto session = std::unique_ptr<mysqlx::Session>(nullptr);
-    try {
-      session = std::make_unique<mysqlx::Session>(conn->client->getSession());
-      session->startTransaction();
-
-      auto user = userRepository->findById(*session, userId);
-      if (user != nullptr) {
-        if (passwordService->removeUserPw(*session, userId)) {
-          userRepository->remove(*session, user);
-          session->commit();
-          return true;
-        } else {
-          throw NotRemovedEntityException(
-              fmt::v9::format("UserService: id={} cannot be removed", userId));
-        }
-      } else {
-        throw NotFoundEntityException(
-            fmt::v9::format("UserService: id={} not in User", userId));
-      }
-    } catch (const NotFoundEntityException &e) {
-      if (session != nullptr) {
-        session->rollback();
-      }
-      serverLogger->error(e.what());
-      throw;
-    } catch (const NotRemovedEntityException &e) {
-      if (session != nullptr) {
-        session->rollback();
-      }
-      serverLogger->error(e.what());
-      throw;
-    } catch (const std::exception &e) {
-      if (session != nullptr) {
-        session->rollback();
-      }
-      auto msg = fmt::v9::format("UserService : {}", e.what());
-      serverLogger->error(msg);
-      throw ServiceException(msg);
-    }
-  }
-
-private:
-  static std::shared_ptr<UserService> instance;
-  static std::mutex createMutex;
-
-  RP userRepository;
-  std::shared_ptr<CompanyService> companyService;
-  std::shared_ptr<PasswordService> passwordService;
-
   UserService() = delete;
 };
 
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "../dao/base/repository.hpp"
+#include "../dao/company/repository.hpp"
+#include "../dao/participant/repository.hpp"
+#include "../dao/room/repository.hpp"
+#include "../dao/user/repository.hpp"
+
+#include "../module/all.hpp"
+using namespace chat::module::exception;
+
+#include "base.hpp"
+#include "batch.hpp"
+
+#include <mysqlx/xdevapi.h>
+
+#include <fmt/core.h>
+
+#include <exception>
+#include <memory>
+#include <mutex>
+
+namespace chat::service {
+
+class VersionService : public BaseService {
+  /**
+   * conditional GET 용
+   * entity를 만들지 않고 단건의 version(row 수, 최종 수정 시간)만 조회
+   */
+public:
+  using Query = BatchService::Query;
+  using TARGET = BatchService::TARGET;
+  using Version = dao::BaseRepository::Version;
+
+  static std::shared_ptr<VersionService> getInstance(L serverLogger, CN conn) {
+    std::lock_guard<std::mutex> lock(createMutex);
+    if (instance == nullptr) {
+      instance = std::make_shared<VersionService>(serverLogger, conn);
+    }
+    return instance;
+  }
+  VersionService(L serverLogger, CN conn)
+      : BaseService(serverLogger, conn),
+        companyRepository(dao::CompanyRepository::getInstance(serverLogger)),
+        userRepository(dao::UserRepository::getInstance(serverLogger)),
+        roomRepository(dao::RoomRepository::getInstance(serverLogger)),
+        participantRepository(
+            dao::ParticipantRepository::getInstance(serverLogger)) {}
+
+  Version find(const Query &query) {
+    auto session = std::unique_ptr<mysqlx::Session>(nullptr);
+    try {
+      session = std::make_unique<mysqlx::Session>(conn->client->getSession());
+      auto version = Version{};
+      switch (query.target) {
+      case TARGET::COMPANY:
+        version = std::dynamic_pointer_cast<dao::CompanyRepository>(
+                      companyRepository)
+                      ->findVersionById(*session, query.id);
+        break;
+      case TARGET::USER:
+        version = std::dynamic_pointer_cast<dao::UserRepository>(userRepository)
+                      ->findVersionById(*session, query.id);
+        break;
+      case TARGET::ROOM:
+        version = std::dynamic_pointer_cast<dao::RoomRepository>(roomRepository)
+                      ->findVersionById(*session, query.id);
+        break;
+      case TARGET::PARTICIPANT:
+        version = std::dynamic_pointer_cast<dao::ParticipantRepository>(
+                      participantRepository)
+                      ->findVersionById(*session, query.id);
+        break;
+      default:
+        // list는 page를 읽은 뒤 BaseService::pageOf에서 계산
+        throw ServiceException(
+            fmt::v9::format("VersionService : list is versioned per page"));
+      }
+      return version;
+    } catch (const std::exception &e) {
+      auto msg = fmt::v9::format("VersionService : {}", e.what());
+      serverLogger->error(msg);
+      throw ServiceException(msg);
+    }
+  }
+
+private:
+  static std::shared_ptr<VersionService> instance;
+  static std::mutex createMutex;
+
+  RP companyRepository;
+  RP userRepository;
+  RP roomRepository;
+  RP participantRepository;
+  VersionService() = delete;
+};
+
+std::shared_ptr<VersionService> VersionService::instance = nullptr;
+std::mutex VersionService::createMutex{};
+} // namespace chat::service
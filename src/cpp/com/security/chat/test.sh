@@ -0,0 +1,11 @@
+#!/bin/bash
+### Build & run every test/*.cpp; stops at the first failure
+if [ ! -d ./build/test ]; then
+    mkdir -p ./build/test
+fi
+
+for source in test/*.cpp; do
+    name=$(basename "$source" .cpp)
+    g++ -g -O0 -std=c++20 "$source" -o "./build/test/$name.out" -lfmt -lssl -lcrypto -pthread || exit 1
+    "./build/test/$name.out" || exit 1
+done
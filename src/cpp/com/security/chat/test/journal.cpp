@@ -0,0 +1,98 @@
+/**
+ * dao::SessionJournal across restarts, including one that crashed halfway
+ * through an append
+ */
+#include "../dao/server_session/journal.hpp"
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace chat;
+
+#define CHECK(condition)                                                       \
+  if ((condition) == false) {                                                  \
+    fprintf(stderr, "%s:%d : CHECK(%s) failed\n", __FILE__, __LINE__,          \
+            #condition);                                                       \
+    exit(1);                                                                   \
+  }
+
+static dao::SessionJournal::Record recordOf(uint64_t sessionId, uint64_t seq) {
+  auto record = dao::SessionJournal::Record{};
+  record.sessionId = sessionId;
+  record.expiredAt = 1000 + sessionId;
+  record.principalId = sessionId * 10;
+  record.op = dao::SessionJournal::OP::SAVE;
+  record.principalType = 'U';
+  record.seq = seq;
+  return record;
+}
+
+static std::vector<dao::SessionJournal::Record>
+reload(const std::string &path) {
+  auto records = std::vector<dao::SessionJournal::Record>{};
+  auto journal = dao::SessionJournal(path);
+  journal.load([&records](const dao::SessionJournal::Record &record) {
+    records.emplace_back(record);
+  });
+  return records;
+}
+
+static void checkRecord(const dao::SessionJournal::Record &record,
+                        uint64_t sessionId, uint64_t seq) {
+  CHECK(record.sessionId == sessionId);
+  CHECK(record.expiredAt == int64_t(1000 + sessionId));
+  CHECK(record.principalId == sessionId * 10);
+  CHECK(record.op == dao::SessionJournal::OP::SAVE);
+  CHECK(record.seq == seq);
+}
+
+int main() {
+  char dir[] = "/tmp/journal_test_XXXXXX";
+  CHECK(mkdtemp(dir) != nullptr);
+  auto path = std::string(dir) + "/sessions";
+  auto journalPath = path + ".journal";
+
+  {
+    auto journal = dao::SessionJournal(path);
+    journal.load([](const dao::SessionJournal::Record &) { CHECK(false); });
+    journal.append(recordOf(1, 1));
+    journal.append(recordOf(2, 2));
+  }
+
+  // a crash in the middle of the third append
+  {
+    auto partial = recordOf(3, 3);
+    auto file = fopen(journalPath.c_str(), "ab");
+    CHECK(file != nullptr);
+    CHECK(fwrite(&partial, 1, sizeof(partial) / 2, file) ==
+          sizeof(partial) / 2);
+    fclose(file);
+  }
+
+  // the cut-short record is ignored, and what follows it stays readable
+  {
+    auto records = std::vector<dao::SessionJournal::Record>{};
+    auto journal = dao::SessionJournal(path);
+    journal.load([&records](const dao::SessionJournal::Record &record) {
+      records.emplace_back(record);
+    });
+    CHECK(records.size() == 2);
+    journal.append(recordOf(4, 4));
+  }
+
+  auto records = reload(path);
+  CHECK(records.size() == 3);
+  checkRecord(records[0], 1, 1);
+  checkRecord(records[1], 2, 2);
+  checkRecord(records[2], 4, 4);
+
+  ::unlink(journalPath.c_str());
+  ::rmdir(dir);
+
+  printf("journal : ok\n");
+  return 0;
+}
@@ -0,0 +1,187 @@
+/**
+ * module::SmtpClient against a stub relay on loopback
+ * The stub accepts exactly one connection, so every mail of the test has to
+ * travel over it
+ */
+#include "../module/smtp.hpp"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace chat;
+
+#define CHECK(condition)                                                       \
+  if ((condition) == false) {                                                  \
+    fprintf(stderr, "%s:%d : CHECK(%s) failed\n", __FILE__, __LINE__,          \
+            #condition);                                                       \
+    exit(1);                                                                   \
+  }
+
+class StubRelay {
+  /**
+   * Answers one SMTP session the way postfix would, except
+   *  - MAIL FROM:<busy@...> : 451 (temporary)
+   *  - RCPT TO:<nobody@...> : 550 (permanent)
+   * Every command & every received message body is recorded
+   */
+public:
+  StubRelay() {
+    listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    auto address = sockaddr_in{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0;
+    CHECK(bind(listenFd, reinterpret_cast<sockaddr *>(&address),
+               sizeof(address)) == 0);
+    CHECK(listen(listenFd, 4) == 0);
+    auto length = socklen_t{sizeof(address)};
+    getsockname(listenFd, reinterpret_cast<sockaddr *>(&address), &length);
+    port = ntohs(address.sin_port);
+    thread = std::thread(&StubRelay::serve, this);
+  }
+
+  ~StubRelay() {
+    if (thread.joinable()) {
+      thread.join();
+    }
+    ::close(listenFd);
+  }
+
+  void join() { thread.join(); }
+
+  uint16_t port;
+  int accepted = 0;
+  std::vector<std::string> commands;
+  std::vector<std::string> messages;
+
+private:
+  void serve() {
+    int fd = accept(listenFd, nullptr, nullptr);
+    ++accepted;
+    reply(fd, "220 stub ESMTP");
+    while (true) {
+      auto line = readLine(fd);
+      if (line.empty() && closed) {
+        break;
+      }
+      commands.push_back(line);
+      if (line.rfind("EHLO", 0) == 0) {
+        reply(fd, "250-stub\r\n250-PIPELINING\r\n250 8BITMIME");
+      } else if (line.rfind("MAIL FROM:<busy@", 0) == 0) {
+        reply(fd, "451 try again later");
+      } else if (line.rfind("RCPT TO:<nobody@", 0) == 0) {
+        reply(fd, "550 no such user");
+      } else if (line == "DATA") {
+        reply(fd, "354 go ahead");
+        auto message = std::string{};
+        for (auto data = readLine(fd); data != "."; data = readLine(fd)) {
+          message += data + "\r\n";
+        }
+        messages.push_back(message);
+        reply(fd, "250 queued");
+      } else if (line == "QUIT") {
+        reply(fd, "221 bye");
+        break;
+      } else {
+        reply(fd, "250 ok");
+      }
+    }
+    ::close(fd);
+  }
+
+  void reply(int fd, const std::string &text) {
+    auto data = text + "\r\n";
+    ::send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+  }
+
+  std::string readLine(int fd) {
+    while (true) {
+      auto end = buffer.find("\r\n");
+      if (end != std::string::npos) {
+        auto line = buffer.substr(0, end);
+        buffer.erase(0, end + 2);
+        return line;
+      }
+      char chunk[512];
+      auto count = ::recv(fd, chunk, sizeof(chunk), 0);
+      if (count <= 0) {
+        closed = true;
+        return "";
+      }
+      buffer.append(chunk, count);
+    }
+  }
+
+  int listenFd;
+  bool closed = false;
+  std::string buffer;
+  std::thread thread;
+};
+
+int main() {
+  auto relay = StubRelay{};
+  {
+    auto client = module::SmtpClient("127.0.0.1", relay.port, "localhost", 5);
+    client.open();
+
+    // a line starting with '.' is doubled, a bare LF becomes CRLF
+    auto sent = client.send("noreply@stub", "alice@stub", "first",
+                            "hello\n.hidden\n..two\nbye");
+    CHECK(sent.isOk());
+
+    // 5xx on RCPT : refused, the envelope is reset, the connection kept
+    auto refused = client.send("noreply@stub", "nobody@stub", "second", "x");
+    CHECK(refused.code == 550);
+    CHECK(refused.isPermanent());
+
+    // 4xx on MAIL : the same, but worth retrying
+    auto deferred = client.send("busy@stub", "alice@stub", "third", "x");
+    CHECK(deferred.code == 451);
+    CHECK(deferred.isPermanent() == false);
+
+    auto last = client.send("noreply@stub", "bob@stub", "fourth", "last");
+    CHECK(last.isOk());
+
+    client.close();
+  }
+  relay.join();
+
+  // every mail travelled over the one connection
+  CHECK(relay.accepted == 1);
+
+  auto expected = std::vector<std::string>{
+      "EHLO localhost",
+      "MAIL FROM:<noreply@stub>",
+      "RCPT TO:<alice@stub>",
+      "DATA",
+      "MAIL FROM:<noreply@stub>",
+      "RCPT TO:<nobody@stub>",
+      "RSET",
+      "MAIL FROM:<busy@stub>",
+      "RSET",
+      "MAIL FROM:<noreply@stub>",
+      "RCPT TO:<bob@stub>",
+      "DATA",
+      "QUIT",
+  };
+  CHECK(relay.commands == expected);
+
+  CHECK(relay.messages.size() == 2);
+  const auto &first = relay.messages[0];
+  CHECK(first.find("To: <alice@stub>\r\n") != std::string::npos);
+  CHECK(first.find("Subject: first\r\n") != std::string::npos);
+  CHECK(first.find("\r\n\r\nhello\r\n..hidden\r\n...two\r\nbye\r\n") !=
+        std::string::npos);
+  CHECK(relay.messages[1].find("\r\n\r\nlast\r\n") != std::string::npos);
+
+  printf("smtp : ok\n");
+  return 0;
+}